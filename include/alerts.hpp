@@ -0,0 +1,112 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/// @brief The condition an alert rule watches for.
+enum class AlertKind {
+    PriceAbove,   // Price rises through `threshold`.
+    PriceBelow,   // Price falls through `threshold`.
+    PercentMove,  // Absolute move over `window_seconds` reaches `threshold` percent.
+    SmaCrossUp,   // Short SMA crosses above the long SMA.
+    SmaCrossDown, // Short SMA crosses below the long SMA.
+};
+
+/// @brief Stable identifier used when persisting an AlertKind, e.g. "price_above".
+const char* alert_kind_name(AlertKind kind);
+std::optional<AlertKind> parse_alert_kind(std::string_view name);
+
+/// @brief A user-defined alert on a single coin.
+struct AlertRule {
+    std::uint64_t id = 0; // Assigned by AlertEngine::add_rule when left at 0.
+    std::string coin_id;
+    AlertKind kind = AlertKind::PriceAbove;
+    double threshold = 0.0;    // Price level in USD, or percent for PercentMove.
+    int window_seconds = 3600; // Lookback for PercentMove.
+    int short_period = 7;      // Sample counts for SMA crossovers.
+    int long_period = 25;
+};
+
+/// @brief A rule that triggered, queued for the UI to pick up.
+struct FiredAlert {
+    std::uint64_t rule_id;
+    std::string coin_id;
+    double price;
+    double timestamp;
+    std::string message;
+};
+
+/// @brief Evaluates price alerts as prices arrive, typically on the network worker threads.
+/// Level and percent-move rules are kept per coin in sorted threshold indexes, and are edge-triggered:
+/// a tick only visits the rules whose threshold lies between the previous and the new value,
+/// so each update costs O(log n + k) for k fired rules regardless of how many rules exist.
+/// Crossover rules are grouped by their SMA periods, and each SMA is a running window sum, so a tick
+/// costs O(1) per distinct period pair rather than O(period) per rule.
+class AlertEngine {
+public:
+    /// @brief Registers a rule and returns its id.
+    /// A level rule whose threshold the price is already past fires right away, or on the coin's
+    /// first tick if no price has been seen yet; after that it fires on each crossing.
+    /// @param restored True for rules loaded from disk. They already fired in an earlier session, so
+    /// they wait for the next crossing instead of re-alerting on every launch.
+    std::uint64_t add_rule(AlertRule rule, bool restored = false);
+
+    /// @return True if a rule with this id existed.
+    bool remove_rule(std::uint64_t id);
+
+    std::vector<AlertRule> rules() const;
+    std::vector<AlertRule> rules_for(const std::string& coin_id) const;
+    std::size_t rule_count() const;
+
+    /// @brief Feeds one price tick. Safe to call from any thread.
+    /// @param timestamp Seconds since epoch.
+    void on_price(const std::string& coin_id, double price, double timestamp);
+
+    /// @brief Feeds a batch of prices observed at the same time.
+    void on_prices(const std::map<std::string, double>& prices, double timestamp);
+
+    /// @brief Hands over every alert fired since the last call.
+    std::vector<FiredAlert> drain_fired();
+
+private:
+    struct Crossovers {
+        std::vector<std::uint64_t> up;
+        std::vector<std::uint64_t> down;
+    };
+
+    // Sum of the newest `period` prices, kept up to date on every tick.
+    struct SmaWindow {
+        double sum = 0.0;
+        int users = 0; // Period pairs using this period.
+    };
+
+    struct CoinIndex {
+        std::multimap<double, std::uint64_t> above; // Level -> rule.
+        std::multimap<double, std::uint64_t> below;
+        std::map<int, std::multimap<double, std::uint64_t>> moves; // Window -> percent threshold -> rule.
+        std::map<int, double> last_move;                           // Window -> last observed move in percent.
+        std::map<std::pair<int, int>, Crossovers> crossovers;      // (short, long) period -> rules.
+        std::map<int, SmaWindow> sma_windows;                      // Period -> running sum.
+        std::deque<std::pair<double, double>> history; // (timestamp, price), oldest first.
+        std::optional<double> last_price;
+    };
+
+    void fire_locked(const AlertRule& rule, double price, double timestamp);
+    void use_sma_window_locked(CoinIndex& coin, int period);
+    void release_sma_window_locked(CoinIndex& coin, int period);
+    void trim_history_locked(CoinIndex& coin, double now) const;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::uint64_t, AlertRule> rules_;
+    std::unordered_map<std::string, CoinIndex> index_;
+    std::unordered_set<std::uint64_t> restored_; // Rules that skip the first-tick check.
+    std::vector<FiredAlert> fired_;
+    std::uint64_t next_id_ = 1;
+};
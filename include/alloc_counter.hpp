@@ -0,0 +1,8 @@
+#pragma once
+#include <cstdint>
+
+/// @brief Number of global `operator new` calls made so far by the calling thread.
+/// Linking this module replaces the global allocation functions with counting versions, so diffing the
+/// value across a frame on the UI thread shows how many heap allocations that frame made, without the
+/// network and logger threads. Only the targets that list alloc_counter.cpp get the replacement.
+std::uint64_t heap_allocation_count();
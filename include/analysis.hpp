@@ -1,4 +1,137 @@
 #pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <tuple>
 #include <vector>
 
-std::vector<double> calculate_sma(const std::vector<double>& prices, int period);
\ No newline at end of file
+std::vector<double> calculate_sma(const std::vector<double>& prices, int period);
+
+/// @brief Computes simple period-over-period returns, `prices[i + 1] / prices[i] - 1`.
+/// @return One element fewer than `prices`; empty if fewer than two prices.
+std::vector<double> calculate_returns(const std::vector<double>& prices);
+
+/// @brief Standard deviation of the series' simple returns, per sampling period (0.01 = 1%).
+/// @return 0 if there are fewer than three prices.
+double calculate_volatility(const std::vector<double>& prices);
+
+/// @brief Downsamples a series with Largest-Triangle-Three-Buckets, preserving its visual shape.
+/// Points are treated as evenly spaced. The first and last points are always kept.
+/// @param out Receives at most `target` values; its capacity is reused.
+void downsample_lttb(const double* values, std::size_t count, std::size_t target, std::vector<double>& out);
+
+/// @brief Risk figures for a set of assets over aligned return series.
+/// Volatilities and VaR are per sampling period of the input and expressed as fractions (0.02 = 2%).
+struct RiskReport {
+    std::size_t assets = 0;
+    std::vector<double> covariance;  // assets x assets, row-major.
+    std::vector<double> correlation; // assets x assets, row-major.
+    std::vector<double> volatility;  // Standard deviation of each asset's returns.
+    double portfolio_volatility = 0.0;
+    double var_historical = 0.0;     // Loss not exceeded with `confidence`, from the empirical distribution.
+    double var_parametric = 0.0;     // Same, assuming normally distributed returns.
+};
+
+/// @brief Computes the covariance/correlation matrix, volatilities and VaR of a weighted portfolio.
+/// The covariance kernel is cache-blocked over assets and time and spread across worker threads,
+/// so it stays interactive for hundreds of assets over long histories.
+/// @param returns One return series per asset. Series are aligned on their most recent points and
+///                truncated to the shortest one.
+/// @param weights Portfolio weight per asset (e.g. market value). Normalised internally.
+/// @param confidence VaR confidence level, e.g. 0.95.
+/// @param threads Worker threads to use; 0 picks the hardware concurrency.
+RiskReport calculate_risk(const std::vector<std::vector<double>>& returns, const std::vector<double>& weights, double confidence = 0.95, unsigned threads = 0);
+
+
+/// @brief Simple moving average kernel for FusedIndicators.
+template <int Period>
+struct SmaKernel {
+    static_assert(Period > 0, "SMA period must be positive");
+    static constexpr std::size_t period = Period;
+    std::vector<double> out;
+    double sum = 0.0;
+
+    void reset(std::size_t n) { out.resize(n); sum = 0.0; }
+    void step(const double* x, std::size_t i) {
+        sum += x[i];
+        if(i >= Period) sum -= x[i - Period];
+        out[i] = i + 1 >= Period ? sum / Period : std::numeric_limits<double>::quiet_NaN();
+    }
+};
+
+/// @brief Exponential moving average kernel for FusedIndicators, seeded with the first full-window SMA.
+template <int Period>
+struct EmaKernel {
+    static_assert(Period > 0, "EMA period must be positive");
+    static constexpr double alpha = 2.0 / (Period + 1);
+    static constexpr std::size_t period = Period;
+    std::vector<double> out;
+    double sum = 0.0;
+
+    void reset(std::size_t n) { out.resize(n); sum = 0.0; }
+    void step(const double* x, std::size_t i) {
+        if(i + 1 < Period) {
+            sum += x[i];
+            out[i] = std::numeric_limits<double>::quiet_NaN();
+        } else if(i + 1 == Period) {
+            out[i] = (sum + x[i]) / Period;
+        } else {
+            out[i] = alpha * x[i] + (1.0 - alpha) * out[i - 1];
+        }
+    }
+};
+
+/// @brief A fixed set of indicator kernels composed at compile time and evaluated in one fused loop.
+/// The overlay set is known up front, so each kernel's step is inlined into a single pass, and the output
+/// buffers are reused across evaluations.
+/// @tparam Kernels Types providing `out`, `period`, `reset(n)` and `step(const double* x, size_t i)`.
+template <typename... Kernels>
+class FusedIndicators {
+    static_assert(sizeof...(Kernels) > 0, "FusedIndicators needs at least one kernel");
+
+public:
+    void evaluate(const std::vector<double>& prices) {
+        const std::size_t n = prices.size();
+        const double* x = prices.data();
+        std::apply([&](auto&... kernel) { (kernel.reset(n), ...); }, kernels_);
+        for(std::size_t i = 0; i < n; i++) {
+            std::apply([&](auto&... kernel) { (kernel.step(x, i), ...); }, kernels_);
+        }
+    }
+
+    /// @brief Updates the outputs after `dropped` points were trimmed from the front of the last evaluated
+    /// series and new points were appended to its back. Only the new points are stepped; the kernels'
+    /// running state carries over. Falls back to a full evaluation when it cannot.
+    /// @param prices The updated series.
+    /// @param dropped How many points were removed from the front since the last evaluation.
+    void extend(const std::vector<double>& prices, std::size_t dropped) {
+        constexpr std::size_t max_period = std::max({Kernels::period...});
+        const std::size_t previous = std::get<0>(kernels_).out.size();
+        if(dropped > previous || previous - dropped < max_period || prices.size() < previous - dropped) {
+            evaluate(prices);
+            return;
+        }
+
+        const std::size_t kept = previous - dropped;
+        const std::size_t n = prices.size();
+        const double* x = prices.data();
+        std::apply([&](auto&... kernel) {
+            ((kernel.out.erase(kernel.out.begin(), kernel.out.begin() + dropped), kernel.out.resize(n)), ...);
+        }, kernels_);
+        for(std::size_t i = kept; i < n; i++) {
+            std::apply([&](auto&... kernel) { (kernel.step(x, i), ...); }, kernels_);
+        }
+    }
+
+    /// @brief Empties every output while keeping the buffers' capacity for the next evaluation.
+    void clear() {
+        std::apply([](auto&... kernel) { (kernel.out.clear(), ...); }, kernels_);
+    }
+
+    template <std::size_t I>
+    const std::vector<double>& get() const { return std::get<I>(kernels_).out; }
+
+private:
+    std::tuple<Kernels...> kernels_;
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include "market_client.hpp"
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// @brief A thread-safe, memory-bounded LRU cache of recently viewed or prefetched coin data.
+/// Entries are immutable snapshots, so a cached coin can be handed straight to the render thread.
+class CoinCache {
+public:
+    /// @param budget_bytes Approximate upper bound on the memory held by cached entries.
+    explicit CoinCache(std::size_t budget_bytes = 16 * 1024 * 1024);
+
+    /// @brief Looks up a coin and marks it as most recently used.
+    /// @return The cached snapshot, or nullptr on a miss.
+    std::shared_ptr<const CoinData> get(const std::string& coin_id);
+
+    /// @brief Checks for a coin without affecting its recency.
+    bool contains(const std::string& coin_id) const;
+
+    /// @brief Inserts or replaces the entry for `data->id`, evicting least recently used entries over budget.
+    /// The newest entry is always kept, even if it alone exceeds the budget.
+    void put(std::shared_ptr<const CoinData> data);
+
+    /// @brief Removes a coin from the cache, e.g. when it is deleted from the watchlist.
+    void erase(const std::string& coin_id);
+
+    /// @brief Returns every cached snapshot, most recently used first.
+    std::vector<std::shared_ptr<const CoinData>> entries() const;
+
+    std::size_t size() const;
+    std::size_t bytes_used() const;
+
+    /// @brief Estimates the heap footprint of a CoinData, used for budget accounting.
+    static std::size_t approx_bytes(const CoinData& data);
+
+private:
+    struct Entry {
+        std::string id;
+        std::shared_ptr<const CoinData> data;
+        std::size_t bytes;
+    };
+
+    void evict_locked();
+
+    mutable std::mutex mutex_;
+    std::list<Entry> lru_; // Front is the most recently used entry.
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    std::size_t budget_;
+    std::size_t used_ = 0;
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+/// @brief An append-only (timestamp, value) series compressed with Gorilla-style encoding.
+/// Timestamps are stored as delta-of-deltas and values as XORs against the previous value, which
+/// shrinks regularly sampled price data to a few bits per point. Points are grouped into fixed-size
+/// blocks that record their time span and min/max, so range queries can skip whole blocks.
+class CompressedSeries {
+public:
+    /// @param block_size Number of points per block. Smaller blocks skip more precisely, larger ones compress better.
+    explicit CompressedSeries(std::size_t block_size = 512);
+
+    /// @brief Appends a point. Timestamps must be non-decreasing (e.g. milliseconds since epoch).
+    /// @return False (and nothing is stored) if `timestamp` is older than the last point.
+    bool append(std::int64_t timestamp, double value);
+
+    std::size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+
+    /// @brief Approximate memory held by the encoded data, in bytes.
+    std::size_t bytes() const;
+
+    std::optional<std::int64_t> first_time() const;
+    std::optional<std::int64_t> last_time() const;
+
+    /// @brief Decodes the whole series into caller-owned buffers, reusing their capacity.
+    /// The output can be handed directly to plotting or indicator functions.
+    void decode(std::vector<double>& times, std::vector<double>& values) const;
+
+    /// @brief Decodes only the points with `from <= timestamp <= to`, skipping blocks outside the range.
+    void decode_range(std::int64_t from, std::int64_t to, std::vector<double>& times, std::vector<double>& values) const;
+
+    /// @brief Returns the (min, max) value in `[from, to]`, decoding only the partially covered edge blocks.
+    /// @return nullopt if no point falls in the range.
+    std::optional<std::pair<double, double>> min_max(std::int64_t from, std::int64_t to) const;
+
+    void clear();
+
+private:
+    struct Block {
+        std::int64_t first_time = 0;
+        std::int64_t last_time = 0;
+        double min = 0.0;
+        double max = 0.0;
+        std::uint32_t count = 0;
+        std::vector<std::uint64_t> words; // Bit stream, most significant bit first.
+        std::size_t bit_count = 0;
+    };
+
+    void write_bits(Block& block, std::uint64_t value, int bits);
+    void decode_block(const Block& block, std::int64_t from, std::int64_t to, std::vector<double>& times, std::vector<double>& values) const;
+
+    std::size_t block_size_;
+    std::size_t count_ = 0;
+    std::vector<Block> blocks_;
+
+    // Encoder state for the open (last) block.
+    std::int64_t prev_time_ = 0;
+    std::int64_t prev_delta_ = 0;
+    std::uint64_t prev_bits_ = 0;
+    int prev_leading_ = -1; // -1 means no XOR window has been written yet in this block.
+    int prev_trailing_ = 0;
+};
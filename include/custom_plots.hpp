@@ -1,5 +1,6 @@
 #pragma once
 #include <imgui.h> // For ImVec4
+#include <vector>
 
 /// @brief Draws a custom candlestick plot using ImPlot primitives.
 /// This is a custom implementation for ImPlot versions that do not include a built-in function.
@@ -14,4 +15,25 @@
 /// @param width_percent The width of the candle body as a percentage of the space between points.
 /// @param bullCol The color for bullish candles (close > open).
 /// @param bearCol The color for bearish candles (close <= open).
-void PlotCandlestick(const char* label_id, const double* xs, const double* opens, const double* closes, const double* lows, const double* highs, int count, bool tooltip = true, float width_percent = 0.25f, ImVec4 bullCol = ImVec4(0, 1, 0, 1), ImVec4 bearCol = ImVec4(1, 0, 0, 1));
\ No newline at end of file
+void PlotCandlestick(const char* label_id, const double* xs, const double* opens, const double* closes, const double* lows, const double* highs, int count, bool tooltip = true, float width_percent = 0.25f, ImVec4 bullCol = ImVec4(0, 1, 0, 1), ImVec4 bearCol = ImVec4(1, 0, 0, 1));
+
+/// @brief Many sparklines packed into one contiguous buffer of downsampled, normalised points.
+/// Built once when market data arrives, so drawing a whole grid is a single cheap pass per frame.
+struct SparklineSet {
+    int points_per_line = 0;
+    std::vector<float> values; // lines * points_per_line values, each scaled to [0, 1] within its line.
+
+    /// @brief Downsamples and normalises every series into the shared buffer.
+    /// Series with fewer than two points are drawn flat.
+    void build(const std::vector<std::vector<double>>& series, int points);
+
+    int lines() const { return points_per_line > 0 ? static_cast<int>(values.size()) / points_per_line : 0; }
+    const float* line(int index) const { return values.data() + static_cast<size_t>(index) * points_per_line; }
+};
+
+/// @brief Draws a normalised sparkline into the current window at the cursor and advances the layout.
+/// @param values Points in [0, 1], e.g. from `SparklineSet::line`.
+/// @param count The number of points.
+/// @param size The size of the sparkline in pixels.
+/// @param color The line color.
+void DrawSparkline(const float* values, int count, ImVec2 size, ImU32 color);
@@ -0,0 +1,42 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <memory>
+#include <utility>
+
+/// @brief A bump allocator for UI strings that only need to live until the end of the current frame.
+/// All storage is allocated once up front; `reset()` at the start of each frame reclaims everything.
+class FrameArena {
+public:
+    explicit FrameArena(std::size_t capacity = 64 * 1024)
+        : buffer_(std::make_unique<char[]>(capacity)), capacity_(capacity) {}
+
+    /// @brief Releases every string handed out since the last reset. Pointers returned earlier become invalid.
+    void reset() { used_ = 0; }
+
+    /// @brief Formats into the arena without touching the heap.
+    /// Output that does not fit in the remaining space is truncated.
+    /// @return A null-terminated string valid until the next `reset()`.
+    template <typename... Args>
+    const char* format(std::format_string<Args...> fmt, Args&&... args) {
+        if(used_ + 1 >= capacity_) return "";
+
+        char* out = buffer_.get() + used_;
+        std::size_t avail = capacity_ - used_ - 1;
+        auto result = std::format_to_n(out, static_cast<std::ptrdiff_t>(avail), fmt, std::forward<Args>(args)...);
+        std::size_t written = std::min(static_cast<std::size_t>(result.size), avail);
+
+        out[written] = '\0';
+        used_ += written + 1;
+        return out;
+    }
+
+    std::size_t used() const { return used_; }
+    std::size_t capacity() const { return capacity_; }
+
+private:
+    std::unique_ptr<char[]> buffer_;
+    std::size_t capacity_;
+    std::size_t used_ = 0;
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+
+/// @brief A dense cross-rate matrix between quote currencies (fiat or crypto, e.g. "usd", "eur", "btc").
+/// Built locally from one batched price response, so any value can be shown in any currency
+/// by a single multiplication without further network requests.
+class FxMatrix {
+public:
+    /// @brief Creates a matrix that only knows its base currency.
+    FxMatrix() : FxMatrix("usd") {}
+    explicit FxMatrix(std::string base);
+
+    /// @brief Derives cross rates from per-coin quotes in several currencies.
+    /// For every currency, the rate against `base` is taken from the coin with the highest base price,
+    /// which carries the most significant digits in the API response.
+    /// @param quotes Map of coin API ID -> (currency -> price).
+    /// @param base The currency every other rate is expressed against.
+    static FxMatrix from_quotes(const std::map<std::string, std::map<std::string, double>>& quotes, const std::string& base = "usd");
+
+    const std::string& base() const { return base_; }
+    const std::vector<std::string>& currencies() const { return currencies_; }
+
+    /// @return The index of `currency` in `currencies()`, or -1 if unknown.
+    int index_of(const std::string& currency) const;
+
+    /// @brief Units of `to` per one unit of `from`.
+    /// @return The cross rate, or 0.0 if either currency is unknown.
+    double rate(const std::string& from, const std::string& to) const;
+    double rate(int from, int to) const { return matrix_[from * currencies_.size() + to]; }
+
+    /// @brief Converts an amount between currencies. Returns 0.0 if either currency is unknown.
+    double convert(double amount, const std::string& from, const std::string& to) const;
+
+private:
+    std::string base_;
+    std::vector<std::string> currencies_; // currencies_[0] is always the base.
+    std::vector<double> matrix_;          // Row-major: matrix_[from * n + to].
+};
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// @brief Extracts rows of numbers from a JSON array of arrays while the document is still arriving.
+/// Chunks can be fed straight from a download callback and may split tokens anywhere; each complete
+/// row is handed to `on_row` as soon as its closing bracket is seen, so nothing holds the whole body.
+/// Targets either the root array (e.g. the ohlc endpoint) or the array under one top-level key
+/// (e.g. "prices" in market_chart). Everything else in the document is skipped.
+class NumericRowStream {
+public:
+    using RowCallback = std::function<void(std::span<const double> row)>;
+
+    /// @param key Top-level key holding the rows, or empty if the root itself is the array.
+    /// @param on_row Called once per row. `null` entries arrive as NaN.
+    NumericRowStream(std::string key, RowCallback on_row);
+
+    /// @brief Consumes the next chunk of the document.
+    /// @return False once the input is known to be malformed; further chunks are ignored.
+    bool feed(std::string_view chunk);
+
+    bool failed() const { return failed_; }
+
+    /// @brief True once the target array has been closed.
+    bool complete() const { return complete_; }
+
+    std::size_t rows() const { return rows_; }
+
+private:
+    enum class State { Scan, String, StringEscape, Number, Literal };
+
+    bool scan(char c);
+    void open(char container);
+    bool close(char container);
+    void end_value();
+    bool finish_number();
+    bool finish_literal();
+    bool in_row() const;
+
+    std::string key_;
+    RowCallback on_row_;
+
+    State state_ = State::Scan;
+    std::vector<char> stack_;  // Open containers, '{' or '['.
+    bool expect_key_ = false;  // Next string in the current object is a key.
+    bool capture_ = false;     // The string being read is a root-level key.
+    std::string token_;        // Pending key, number or literal text.
+    std::string last_key_;     // Most recent root-level key.
+
+    int target_depth_ = -1;    // Stack depth of the target array once it is open.
+    std::vector<double> row_;
+    std::size_t rows_ = 0;
+    bool failed_ = false;
+    bool complete_ = false;
+};
@@ -0,0 +1,116 @@
+#pragma once
+#include <cstddef>
+#include <deque>
+#include <limits>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// @brief Direction of a trade. The numeric values are persisted and must stay stable.
+enum class TradeSide : int {
+    Buy = 0,         // Bought at `price`; the fee adds to the cost basis.
+    Sell = 1,        // Sold at `price`; realizes PnL against the matched lots, net of the fee.
+    TransferIn = 2,  // Deposited from elsewhere; `price` is the cost basis carried in (may be 0).
+    TransferOut = 3, // Withdrawn; the matched cost basis leaves without realizing PnL.
+};
+
+/// @brief How sells and withdrawals are matched against earlier lots.
+enum class CostMethod { Fifo, Lifo, Average };
+
+const char* trade_side_name(TradeSide side);
+/// @brief Stable identifier used when persisting a CostMethod, e.g. "fifo".
+const char* cost_method_name(CostMethod method);
+std::optional<CostMethod> parse_cost_method(std::string_view name);
+
+/// @brief A single trade as entered by the user.
+struct Trade {
+    std::string coin_id;
+    TradeSide side = TradeSide::Buy;
+    double amount = 0.0;    // Coin units, always positive.
+    double price = 0.0;     // USD per unit.
+    double fee = 0.0;       // USD.
+    double timestamp = 0.0; // Seconds since epoch.
+};
+
+/// @brief Holdings and PnL of one coin after every trade up to some point in time.
+struct PositionState {
+    double amount = 0.0;       // Coin units held.
+    double cost_basis = 0.0;   // USD cost of the held units, fees included.
+    double realized_pnl = 0.0; // USD, net of fees.
+    double fees = 0.0;         // USD paid in fees so far.
+    std::size_t trades = 0;
+
+    double average_cost() const { return amount > 0.0 ? cost_basis / amount : 0.0; }
+    double unrealized_pnl(double price) const { return amount * price - cost_basis; }
+};
+
+/// @brief An append-only trade ledger with lot-based cost basis.
+/// Trades are stored per coin in columns, and after each one the running position is recorded in
+/// prefix columns, so the position at any point in time is a binary search over the timestamps:
+/// O(log n) regardless of how many trades there are. Appends match lots incrementally in amortized O(1).
+class Ledger {
+public:
+    /// @brief The raw trades of one coin, one column per field, in time order.
+    struct Columns {
+        std::vector<double> time;
+        std::vector<TradeSide> side;
+        std::vector<double> amount;
+        std::vector<double> price;
+        std::vector<double> fee;
+    };
+
+    explicit Ledger(CostMethod method = CostMethod::Fifo);
+
+    /// @brief Records a trade. Trades of a coin must be appended in non-decreasing time order.
+    /// @return False (and nothing is stored) if the trade is older than the coin's last trade,
+    /// has a non-positive amount or negative price/fee, or sells/withdraws more than is held.
+    bool append(const Trade& trade);
+
+    /// @brief Switches the lot matching method and recomputes every position.
+    void set_method(CostMethod method);
+    CostMethod method() const { return method_; }
+
+    /// @brief Total number of trades across all coins.
+    std::size_t size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+
+    /// @brief Coins with at least one trade, sorted by API ID.
+    std::vector<std::string> coins() const;
+
+    /// @return The coin's trades, or nullptr if it has none.
+    const Columns* columns(const std::string& coin_id) const;
+
+    /// @brief The coin's position after every trade with `timestamp <= at`.
+    PositionState position(const std::string& coin_id, double at = std::numeric_limits<double>::infinity()) const;
+
+    /// @brief Drops every trade of one coin, e.g. when it is removed from the watchlist.
+    /// @return The number of trades removed.
+    std::size_t erase(const std::string& coin_id);
+
+    void clear();
+
+private:
+    struct Lot {
+        double amount;
+        double unit_cost;
+    };
+
+    struct Book {
+        Columns trades;
+        // Running position after each trade, parallel to `trades`.
+        std::vector<double> held;
+        std::vector<double> cost;
+        std::vector<double> realized;
+        std::vector<double> fees;
+        std::deque<Lot> lots; // Open lots, oldest first. A single pooled lot under Average.
+    };
+
+    bool apply(Book& book, TradeSide side, double amount, double price, double fee);
+    double take_lots(Book& book, double amount);
+
+    CostMethod method_;
+    std::map<std::string, Book> books_;
+    std::size_t count_ = 0;
+};
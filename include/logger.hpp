@@ -0,0 +1,125 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <format>
+#include <memory>
+#include <string>
+#include <thread>
+
+/// @brief Severity of a log line, lowest first.
+enum class LogLevel : int { Trace = 0, Debug, Info, Warn, Error, Off };
+
+/// @brief Short upper-case name used in the log output, e.g. "WARN".
+const char* log_level_name(LogLevel level);
+
+// Levels below this are compiled out entirely: the call and its arguments generate no code.
+// Override per build, e.g. -DLOG_COMPILED_LEVEL=2 to keep only Info and above.
+#ifndef LOG_COMPILED_LEVEL
+#define LOG_COMPILED_LEVEL 1
+#endif
+
+/// @brief Where and how the background writer stores log lines.
+struct LoggerOptions {
+    std::string path = "tracker.log";
+    std::size_t max_bytes = 1024 * 1024; // Rotate once the current file reaches this size.
+    int max_files = 3;                   // tracker.log, tracker.log.1, ... tracker.log.<max_files - 1>.
+    bool echo_to_console = true;         // Also print Warn and above to stderr.
+};
+
+/// @brief Asynchronous logger for the network workers.
+/// Callers format straight into a slot of a bounded lock-free MPSC ring (no locks, no heap),
+/// and a single background thread writes the slots out to a rotating file. When the ring is full
+/// new lines are dropped and counted instead of blocking the caller.
+class Logger {
+public:
+    static constexpr std::size_t LINE_CAPACITY = 240; // Longer messages are truncated.
+
+    /// @param capacity Number of ring slots, rounded up to a power of two.
+    explicit Logger(std::size_t capacity = 1024);
+    ~Logger();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    /// @brief Opens the log file and starts the writer thread. Lines logged before this are kept in the ring.
+    void start(LoggerOptions options = {});
+
+    /// @brief Writes out everything queued so far and stops the writer thread.
+    void stop();
+
+    /// @brief Blocks until every line logged before the call has been written. No-op if not started.
+    void flush();
+
+    void set_level(LogLevel level) { level_.store(level, std::memory_order_relaxed); }
+    LogLevel level() const { return level_.load(std::memory_order_relaxed); }
+
+    /// @brief Lines lost because the ring was full.
+    std::uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    /// @brief Formats and enqueues one line. Safe to call from any thread.
+    template <typename... Args>
+    void log(LogLevel level, std::format_string<Args...> fmt, Args&&... args) {
+        if(level < level_.load(std::memory_order_relaxed)) return;
+
+        std::size_t pos;
+        Slot* slot = claim(pos);
+        if(!slot) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        auto result = std::format_to_n(slot->text, LINE_CAPACITY, fmt, std::forward<Args>(args)...);
+        slot->length = static_cast<std::uint16_t>(std::min<std::size_t>(result.size, LINE_CAPACITY));
+        slot->level = level;
+        slot->time = std::chrono::system_clock::now();
+        slot->sequence.store(pos + 1, std::memory_order_release);
+    }
+
+private:
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        std::chrono::system_clock::time_point time;
+        LogLevel level;
+        std::uint16_t length;
+        char text[LINE_CAPACITY];
+    };
+
+    Slot* claim(std::size_t& pos);
+    bool drain_one();
+    void run(std::stop_token stop);
+    void write_line(const Slot& slot);
+    void rotate();
+
+    std::unique_ptr<Slot[]> slots_;
+    std::size_t mask_;
+    alignas(64) std::atomic<std::size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<std::size_t> written_{0}; // Slots consumed by the writer so far.
+    std::size_t dequeue_pos_ = 0;                     // Owned by the writer thread.
+
+    std::atomic<LogLevel> level_{LogLevel::Info};
+    std::atomic<std::uint64_t> dropped_{0};
+
+    LoggerOptions options_;
+    std::FILE* file_ = nullptr;
+    std::size_t file_bytes_ = 0;
+    std::jthread writer_;
+};
+
+/// @brief The process-wide logger used by the LOG_* macros.
+Logger& app_logger();
+
+#define LOG_AT(level, ...)                                                      \
+    do {                                                                        \
+        if constexpr(static_cast<int>(level) >= LOG_COMPILED_LEVEL) {           \
+            app_logger().log(level, __VA_ARGS__);                               \
+        }                                                                       \
+    } while(0)
+
+#define LOG_TRACE(...) LOG_AT(LogLevel::Trace, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_AT(LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(...)  LOG_AT(LogLevel::Info, __VA_ARGS__)
+#define LOG_WARN(...)  LOG_AT(LogLevel::Warn, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LogLevel::Error, __VA_ARGS__)
@@ -4,6 +4,11 @@
 #include <vector>
 #include <map>
 #include <future>
+#include <stop_token>
+#include "snapshot.hpp"
+#include "fx.hpp"
+
+class NumericRowStream;
 
 /// @brief Maps a user-facing coin name to its API identifier.
 struct CoinDef {
@@ -18,6 +23,7 @@ struct CoinData
     std::string id;
     double current_price;
     std::vector<double> price_history;
+    std::vector<double> history_time; // Seconds since epoch for each `price_history` point.
     std::vector<double> time;
     std::vector<double> open;
     std::vector<double> high;
@@ -25,25 +31,67 @@ struct CoinData
     std::vector<double> close;
 };
 
+/// @brief Latest prices for a batch of coins, with the FX rates implied by the same response.
+struct PriceBatch {
+    std::map<std::string, double> prices; // Coin API ID -> price in the base currency (USD).
+    FxMatrix fx;                          // Cross rates between every requested quote currency.
+};
+
+/// @brief One row of the coins/markets endpoint: enough to draw a watchlist tile without further requests.
+struct MarketSummary {
+    std::string id;
+    double current_price = 0.0;      // In the base currency (USD).
+    double change_24h = 0.0;         // Percent change over 24 hours.
+    std::vector<double> sparkline;   // Hourly prices over the last 7 days, oldest first.
+};
+
 /// @brief A client for interacting with the CoinGecko cryptocurrency API.
 class MarketClient {
 public:
+    /// @brief The public CoinGecko API. A mirror serving the same routes can be used instead.
+    static constexpr const char* DEFAULT_BASE_URL = "https://api.coingecko.com/api/v3";
+
+    /// @param base_url API root without a trailing slash, e.g. a local caching mirror.
+    explicit MarketClient(std::string base_url = DEFAULT_BASE_URL);
+
+    const std::string& base_url() const { return base_url_; }
+
+    /// @brief The currency all prices and histories are fetched in. Other currencies are derived via `FxMatrix`.
+    static constexpr const char* BASE_CURRENCY = "usd";
+
     /// @brief Parses a JSON string to extract the current price of a coin.
     /// @param json_body The raw JSON response from the API.
     /// @param coin_id The API identifier for the coin (e.g., "bitcoin").
     /// @return A CoinData object with price info, or nullopt on failure.
     static std::optional<CoinData> parse_coin_price(const std::string& json_body, const std::string& coin_id);
 
-    /// @brief Parses a JSON string to extract historical price points.
+    /// @brief Parses a JSON string to extract historical price points, without their timestamps.
+    /// Shorthand for `parse_history_points` when only the prices are needed.
     /// @param json_body The raw JSON response from the market_chart endpoint.
     /// @return A vector of price points. Returns an empty vector on failure.
     static std::vector<double> parse_history(const std::string& json_body);
 
+    /// @brief Parses the timestamped price points of a market_chart or market_chart/range response.
+    /// @param json_body The raw JSON response.
+    /// @param times Receives the timestamps in seconds since epoch.
+    /// @param prices Receives the matching prices. Both vectors are cleared first and left empty on failure.
+    static void parse_history_points(const std::string& json_body, std::vector<double>& times, std::vector<double>& prices);
+
     /// @brief Parses a JSON string containing multiple coin prices.
     /// @param json_body The raw JSON response from the simple/price endpoint.
     /// @return A map of coin API IDs to their USD price.
     static std::map<std::string, double> parse_multi_price(const std::string& json_body);
 
+    /// @brief Parses a simple/price response requested with several `vs_currencies`.
+    /// @param json_body The raw JSON response from the simple/price endpoint.
+    /// @return A map of coin API ID -> (currency -> price). Returns an empty map on failure.
+    static std::map<std::string, std::map<std::string, double>> parse_multi_quote(const std::string& json_body);
+
+    /// @brief Parses a coins/markets response requested with `sparkline=true`.
+    /// @param json_body The raw JSON response from the markets endpoint.
+    /// @return One summary per coin, in response order. Returns an empty vector on failure.
+    static std::vector<MarketSummary> parse_markets(const std::string& json_body);
+
     /// @brief Parses a JSON string from a coin search query.
     /// @param json_body The raw JSON response from the search endpoint.
     /// @return A vector of `CoinDef` objects matching the search.
@@ -54,11 +102,39 @@ public:
     /// @return A complete CoinData object, or nullopt on network/API failure.
     std::optional<CoinData> get_coin_data(const std::string& coin_id);
 
+    /// @brief The span of price history kept per coin.
+    static constexpr double HISTORY_WINDOW_SECONDS = 24 * 60 * 60;
+
+    /// @brief Refreshes a previously fetched coin, downloading only the history newer than its last point.
+    /// The new points are appended to a copy of `previous` and anything older than the history window is
+    /// trimmed from the front; OHLC candles are carried over. Falls back to `get_coin_data` when `previous`
+    /// has no timestamped history or is older than the window.
+    /// @param previous The last known data for the coin.
+    /// @param current_price The coin's price if the caller already has a fresh one, saving the price request.
+    /// @return The updated CoinData, or nullopt on network/API failure.
+    std::optional<CoinData> refresh_coin_data(const CoinData& previous, std::optional<double> current_price = std::nullopt);
+
     /// @brief Fetches the current price for multiple coins in a single request.
     /// @param coin_ids A vector of API identifiers for the coins.
     /// @return A map of coin API IDs to their USD price. Returns an empty map on failure.
     std::map<std::string, double> get_multi_price(const std::vector<std::string>& coin_ids);
 
+    /// @brief Fetches prices for multiple coins in all requested quote currencies in a single request.
+    /// @param coin_ids A vector of API identifiers for the coins.
+    /// @param vs_currencies Quote currencies to derive cross rates for (e.g. "eur", "btc"). USD is always included.
+    /// @param stop Aborts the transfer once stop is requested, e.g. when another source already answered.
+    /// @return Base-currency prices plus the cross-rate matrix. Empty on failure.
+    PriceBatch get_price_batch(const std::vector<std::string>& coin_ids, const std::vector<std::string>& vs_currencies, std::stop_token stop = {});
+
+    /// @brief Fetches price, 24h change and a 7-day sparkline for every coin, one page of up to
+    /// `MARKETS_PAGE_SIZE` coins per request instead of one history request per coin.
+    /// @param coin_ids A vector of API identifiers for the coins.
+    /// @return Summaries for every coin that was returned. Pages that fail are skipped.
+    std::vector<MarketSummary> get_markets(const std::vector<std::string>& coin_ids);
+
+    /// @brief The largest page the markets endpoint serves in a single response.
+    static constexpr std::size_t MARKETS_PAGE_SIZE = 250;
+
     /// @brief Searches for coins by name, ticker, or ID.
     /// @param query The search term.
     /// @return A vector of `CoinDef` objects matching the query. Returns an empty vector on failure.
@@ -75,5 +151,22 @@ public:
     /// @return True on success, false on network/API failure.
     bool fetch_ohlc(const std::string& coin_id, CoinData& data);
 
-    std::future<bool> fetch_ohlc_async(const std::string& coin_id, CoinData& data);
+    /// @brief Fetches OHLC data on a worker thread and publishes it as a new snapshot of `slot`.
+    /// The candles are parsed into a private buffer and merged with a copy of the current snapshot,
+    /// so readers of `slot` never observe a half-filled series. The result is dropped if the slot
+    /// has meanwhile switched to a different coin.
+    /// @param coin_id The API identifier for the coin.
+    /// @param slot The snapshot slot the render thread reads from. Must outlive the returned future.
+    /// @return A future resolving to true if new candles were published.
+    std::future<bool> fetch_ohlc_async(const std::string& coin_id, SnapshotSlot<CoinData>& slot);
+
+private:
+    /// @brief Fetches only the current price, without any history.
+    std::optional<CoinData> fetch_current_price(const std::string& coin_id);
+
+    /// @brief GETs `url` with compressed transfer, feeding the body to `stream` while it downloads.
+    /// @return The HTTP status code, or 0 if a 200 response was malformed or cut short.
+    long stream_get(const std::string& url, NumericRowStream& stream) const;
+
+    std::string base_url_;
 };
@@ -1,15 +1,37 @@
 #pragma once
 #include "market_client.hpp"
+#include "alerts.hpp"
+#include "ledger.hpp"
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <optional>
 
 struct PortfolioEntry {
     double amount = 0.0;
     double buyPrice = 0.0;
 };
 
+/// @brief Last-known market state, saved on refresh/shutdown and restored on launch
+/// so the first frame can render a (stale) dashboard before the network answers.
+struct AppSnapshot {
+    double saved_at = 0.0;                    // Seconds since epoch.
+    std::map<std::string, double> prices;     // Last USD price per coin.
+    std::map<std::string, double> fx_rates;   // Units of each quote currency per USD.
+    std::vector<std::shared_ptr<const CoinData>> coins; // Cached histories, most recently used first.
+};
+
 void save_coins(const std::vector<CoinDef>& coins);
 std::vector<CoinDef> load_coins();
 void save_portfolio(const std::map<std::string, PortfolioEntry>& portfolio);
-std::map<std::string, PortfolioEntry> load_portfolio();
\ No newline at end of file
+std::map<std::string, PortfolioEntry> load_portfolio();
+void save_alerts(const std::vector<AlertRule>& rules);
+std::vector<AlertRule> load_alerts();
+void save_ledger(const Ledger& ledger);
+Ledger load_ledger();
+/// @brief Writes the snapshot to a temporary file and renames it over `path`, so a crash mid-write never
+/// leaves a truncated snapshot behind.
+void save_snapshot(const AppSnapshot& snapshot, const std::string& path = "snapshot.msgpack");
+/// @return nullopt if the file is missing, corrupt or from another format version.
+std::optional<AppSnapshot> load_snapshot(const std::string& path = "snapshot.msgpack");
\ No newline at end of file
@@ -0,0 +1,119 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// The price board is a POSIX shared-memory segment with a fixed layout. One collector process writes
+// it and any number of local processes map it read-only. Every slot is guarded by a seqlock. Readers
+// load straight from the mapping with no system calls, locks or parsing, and retry a slot only if
+// the writer was mid-update. On platforms without POSIX shared memory, `create` and `attach` fail.
+
+/// @brief Name of the segment the collector publishes to, as passed to `shm_open`.
+constexpr const char* PRICE_BOARD_NAME = "/market_tracker_board";
+constexpr std::size_t PRICE_BOARD_COINS = 256;       // Coin slots; slots are never reused.
+constexpr std::size_t PRICE_BOARD_HISTORY = 512;     // Points per coin, enough for 24h at 5-minute granularity.
+constexpr std::size_t PRICE_BOARD_CURRENCIES = 16;
+constexpr std::size_t PRICE_BOARD_ID_LENGTH = 64;    // Longest coin API ID that fits in a slot.
+
+struct BoardLayout;
+
+/// @brief A coin's latest price on the board.
+struct BoardQuote {
+    double price = 0.0;      // In the base currency (USD).
+    double updated_at = 0.0; // Seconds since epoch.
+};
+
+/// @brief Portfolio totals as computed by the collector, in the base currency.
+struct PortfolioValuation {
+    double net_worth = 0.0;
+    double cost_basis = 0.0;
+    double realized_pnl = 0.0;
+    double updated_at = 0.0;
+};
+
+/// @brief The writing side of the board. Only one may exist per segment name.
+class PriceBoardWriter {
+public:
+    /// @brief Creates the segment and maps it read-write, replacing one abandoned by a crashed collector.
+    /// @return nullptr if shared memory is unavailable or another collector owns the segment.
+    static std::unique_ptr<PriceBoardWriter> create(const std::string& name = PRICE_BOARD_NAME);
+
+    /// @brief Unmaps and unlinks the segment. Attached readers keep their (now frozen) mapping.
+    ~PriceBoardWriter();
+
+    PriceBoardWriter(const PriceBoardWriter&) = delete;
+    PriceBoardWriter& operator=(const PriceBoardWriter&) = delete;
+
+    /// @return False if the coin does not fit: the ID is too long or every slot is taken.
+    bool publish_price(const std::string& coin_id, double price, double at);
+
+    /// @brief Replaces the coin's history. Only the most recent `PRICE_BOARD_HISTORY` points are kept.
+    bool publish_history(const std::string& coin_id, const std::vector<double>& times, const std::vector<double>& prices);
+
+    /// @param rates Units of each currency per one unit of the base currency; extra currencies are dropped.
+    void publish_fx(const std::map<std::string, double>& rates);
+
+    void publish_valuation(const PortfolioValuation& valuation);
+
+    /// @brief Marks the collector as alive without announcing new data.
+    void heartbeat(double at);
+
+    /// @brief Marks the end of an update cycle, so readers polling `publishes()` see one change per cycle.
+    void commit(double at);
+
+private:
+    PriceBoardWriter(std::string name, int fd, BoardLayout* board);
+    std::optional<std::size_t> slot_for(const std::string& coin_id);
+
+    std::string name_;
+    int fd_ = -1;
+    BoardLayout* board_ = nullptr;
+    std::unordered_map<std::string, std::size_t> slots_;
+};
+
+/// @brief A read-only view of the board.
+/// Reads are wait-free: a slot that keeps changing under the reader is reported as unavailable
+/// after a few attempts instead of spinning. Not safe to share between threads; attach one per thread.
+class PriceBoardReader {
+public:
+    /// @return nullptr if no collector has created the segment, or its layout does not match this build.
+    static std::unique_ptr<PriceBoardReader> attach(const std::string& name = PRICE_BOARD_NAME);
+
+    ~PriceBoardReader();
+
+    PriceBoardReader(const PriceBoardReader&) = delete;
+    PriceBoardReader& operator=(const PriceBoardReader&) = delete;
+
+    /// @brief Increases with every committed update cycle; a cheap check for new data.
+    std::uint64_t publishes() const;
+
+    /// @brief Time of the collector's last heartbeat or commit, in seconds since epoch. A stale value means the collector stopped.
+    double heartbeat() const;
+
+    std::size_t coin_count() const;
+
+    std::optional<BoardQuote> quote(const std::string& coin_id) const;
+
+    /// @brief Copies the coin's history into the given buffers, reusing their capacity.
+    /// @return False if the coin has no history or it could not be read consistently.
+    bool history(const std::string& coin_id, std::vector<double>& times, std::vector<double>& prices) const;
+
+    std::optional<PortfolioValuation> valuation() const;
+
+    /// @return Units of each currency per one unit of the base currency; empty if none were published.
+    std::map<std::string, double> fx_rates() const;
+
+private:
+    explicit PriceBoardReader(const BoardLayout* board);
+    std::optional<std::size_t> slot_of(const std::string& coin_id) const;
+
+    const BoardLayout* board_ = nullptr;
+    // Coin IDs never change once their slot is published, so the lookup only grows.
+    mutable std::unordered_map<std::string, std::size_t> slots_;
+    mutable std::size_t indexed_ = 0;
+};
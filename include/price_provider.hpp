@@ -0,0 +1,132 @@
+#pragma once
+#include "market_client.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// @brief A source of current prices. Implementations must be safe to call from several threads at once.
+class PriceProvider {
+public:
+    virtual ~PriceProvider() = default;
+
+    /// @brief Short identifier shown in diagnostics, e.g. "coingecko".
+    virtual const std::string& name() const = 0;
+
+    /// @brief Fetches prices for the coins in the base currency plus cross rates for `vs_currencies`.
+    /// @param stop Requested once the answer is no longer wanted; a slow request should give up early.
+    /// @return nullopt on network/API failure, an empty answer or a stop.
+    virtual std::optional<PriceBatch> fetch_prices(const std::vector<std::string>& coin_ids, const std::vector<std::string>& vs_currencies, std::stop_token stop) = 0;
+};
+
+/// @brief Prices from the CoinGecko simple/price API, or from any mirror serving the same routes.
+class CoinGeckoProvider : public PriceProvider {
+public:
+    explicit CoinGeckoProvider(std::string base_url = MarketClient::DEFAULT_BASE_URL, std::string name = "coingecko");
+
+    const std::string& name() const override { return name_; }
+    std::optional<PriceBatch> fetch_prices(const std::vector<std::string>& coin_ids, const std::vector<std::string>& vs_currencies, std::stop_token stop) override;
+
+private:
+    std::string name_;
+    MarketClient client_;
+};
+
+/// @brief A stand-in provider answering from a fixed quote table, e.g. for offline runs and tests.
+/// The delay and failure switches simulate a slow or broken upstream.
+class StaticPriceProvider : public PriceProvider {
+public:
+    /// @param quotes Coin API ID -> (currency -> price), as returned by `MarketClient::parse_multi_quote`.
+    StaticPriceProvider(std::string name, std::map<std::string, std::map<std::string, double>> quotes);
+
+    const std::string& name() const override { return name_; }
+    std::optional<PriceBatch> fetch_prices(const std::vector<std::string>& coin_ids, const std::vector<std::string>& vs_currencies, std::stop_token stop) override;
+
+    /// @brief Delays every answer; a stop cuts the delay short.
+    void set_delay(std::chrono::milliseconds delay) { delay_ms_.store(delay.count(), std::memory_order_relaxed); }
+    void set_failing(bool failing) { failing_.store(failing, std::memory_order_relaxed); }
+
+private:
+    std::string name_;
+    std::map<std::string, std::map<std::string, double>> quotes_;
+    std::atomic<std::int64_t> delay_ms_{0};
+    std::atomic<bool> failing_{false};
+};
+
+/// @brief Recent behaviour of one provider, as tracked by HedgedPriceSource.
+struct ProviderHealth {
+    std::string name;
+    double p95_ms = 0.0;       // Over recent successful requests; 0 until the first one.
+    double success_rate = 1.0; // Exponentially weighted, recent requests count most.
+    double score = 0.0;        // Higher is better; providers are tried in score order.
+    std::uint64_t requests = 0;
+    std::uint64_t wins = 0;    // Requests whose answer was the one used.
+};
+
+/// @brief Tuning for HedgedPriceSource.
+struct HedgingOptions {
+    std::chrono::milliseconds min_hedge_delay{100};      // Never hedge sooner than this.
+    std::chrono::milliseconds default_hedge_delay{1500}; // Used until a provider has latency samples.
+    std::chrono::milliseconds timeout{15000};            // Give up on the whole request after this.
+};
+
+/// @brief Fetches prices from the healthiest provider and hedges against slow answers.
+/// If the current provider has not answered within its own p95 latency (or has failed), the same
+/// request is sent to the next provider, and the first good answer wins. Attempts run on a pool of
+/// persistent workers, one per provider, so a refresh pays no thread creation. Once the request is
+/// decided the remaining attempts are told to stop, and report how long they ran before giving up.
+class HedgedPriceSource {
+public:
+    explicit HedgedPriceSource(std::vector<std::shared_ptr<PriceProvider>> providers, HedgingOptions options = {});
+
+    /// @brief Stops the workers. Attempts still running were already told to stop when their request ended.
+    ~HedgedPriceSource();
+
+    HedgedPriceSource(const HedgedPriceSource&) = delete;
+    HedgedPriceSource& operator=(const HedgedPriceSource&) = delete;
+
+    /// @brief Blocks until the first good answer, every provider failed, or the timeout passed.
+    /// @return The winning batch, or an empty batch on failure.
+    PriceBatch fetch_prices(const std::vector<std::string>& coin_ids, const std::vector<std::string>& vs_currencies);
+
+    /// @brief A snapshot of every provider's health, in the order they were registered.
+    std::vector<ProviderHealth> health() const;
+
+private:
+    // Shared with the request threads, which may outlive the call that started them.
+    struct Tracker {
+        std::shared_ptr<PriceProvider> provider;
+        mutable std::mutex mutex;
+        std::deque<double> latencies_ms; // Most recent successful requests.
+        double success_rate = 1.0;
+        std::uint64_t requests = 0;
+        std::uint64_t wins = 0;
+
+        void record(bool ok, double latency_ms);
+        // A request stopped for a faster answer. Its run time is only a lower bound on its latency, but it
+        // still pushes p95 up, so a provider that keeps losing drops down the order.
+        void record_stopped(double latency_ms);
+        double p95_ms() const; // 0 without samples. Caller holds `mutex`.
+    };
+
+    double score(const Tracker& tracker) const;
+    std::chrono::milliseconds hedge_delay(const Tracker& tracker) const;
+    void run_worker(std::stop_token stop);
+
+    std::vector<std::shared_ptr<Tracker>> trackers_;
+    HedgingOptions options_;
+    std::mutex queue_mutex_;
+    std::condition_variable_any queue_ready_;
+    std::deque<std::function<void()>> queue_;
+    std::vector<std::jthread> workers_;
+};
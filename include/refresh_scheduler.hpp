@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// @brief Tuning for RefreshScheduler. Times are in seconds.
+struct RefreshOptions {
+    double base_interval = 60.0;       // Interval of an average coin: average volatility and holding, not on screen.
+    double min_interval = 15.0;
+    double max_interval = 600.0;
+    double requests_per_minute = 2.0;  // Sustained budget: the old fixed refresh spent up to two a minute on the shown coin.
+    double burst = 3.0;                // Requests that may be spent back to back after a quiet spell.
+    double visible_reserve = 1.0;      // Left in the budget by a batch with an on-screen coin, for its chart.
+    double coalesce = 0.5;             // A batch also takes coins at least this far through their interval.
+};
+
+/// @brief Decides when each coin's price is refreshed.
+/// Every coin gets its own interval from its recent volatility, its share of the portfolio and whether
+/// it is on screen, and its next due time sits in a min-heap. When the earliest coin falls due, one
+/// batch request refreshes it together with every coin close to due, so quiet coins ride along with
+/// busy ones instead of costing requests of their own. A token bucket caps the total request rate.
+class RefreshScheduler {
+public:
+    explicit RefreshScheduler(RefreshOptions options = {});
+
+    /// @brief Starts scheduling a coin; it is due immediately. Does nothing if it is already tracked.
+    void track(const std::string& coin_id, double now);
+
+    void untrack(const std::string& coin_id);
+
+    bool tracks(const std::string& coin_id) const { return coins_.contains(coin_id); }
+    std::size_t size() const { return coins_.size(); }
+
+    /// @param volatility Standard deviation of recent returns, e.g. from `calculate_volatility`.
+    void set_volatility(const std::string& coin_id, double volatility);
+
+    /// @param weight The coin's fraction of the portfolio's value, 0 if not held.
+    void set_weight(const std::string& coin_id, double weight);
+
+    void set_visible(const std::string& coin_id, bool visible);
+
+    /// @brief Takes the coins to refresh now, if the earliest one is due and the budget allows a request.
+    /// The returned coins count as refreshed and are rescheduled; one request is charged. A batch with an
+    /// on-screen coin waits until `visible_reserve` more is available, so the caller can spend it on that coin.
+    /// @return Empty when nothing is due yet or the budget is spent.
+    std::vector<std::string> take_due(double now);
+
+    /// @brief Records a refresh made outside the schedule (e.g. a user click) and charges its requests.
+    /// The budget may go into debt, which delays the next scheduled refresh.
+    void mark_refreshed(const std::vector<std::string>& coin_ids, double now, double requests);
+
+    /// @brief Spends `requests` from the budget if it holds that many.
+    bool try_spend(double now, double requests);
+
+    /// @brief Earliest time `take_due` can return coins; infinity if nothing is tracked.
+    double next_due(double now);
+
+    /// @brief The coin's current refresh interval, or 0 if it is not tracked.
+    double interval(const std::string& coin_id) const;
+
+private:
+    struct Coin {
+        double volatility = 0.0; // 0 while unknown.
+        double weight = 0.0;
+        bool visible = false;
+        double last = 0.0;       // Time of the last refresh.
+        double interval = 0.0;
+        double due = 0.0;
+        std::uint64_t version = 0;
+        bool refreshed = false;  // False until the first refresh; such a coin stays due.
+    };
+
+    // Heap entries are never updated in place. Rescheduling pushes a new entry and bumps the coin's
+    // version, and entries whose version is behind are discarded when they reach the top.
+    struct Slot {
+        double due;
+        std::uint64_t version;
+        std::string coin_id;
+        bool operator>(const Slot& other) const { return due > other.due; }
+    };
+
+    double mean_volatility() const;
+    double interval_for(const Coin& coin, double mean_volatility) const;
+    void schedule(const std::string& coin_id, Coin& coin, double due);
+    void rebalance();
+    void refill(double now);
+    double required_tokens(bool visible) const;
+    bool pop_stale();
+
+    RefreshOptions options_;
+    std::unordered_map<std::string, Coin> coins_;
+    std::priority_queue<Slot, std::vector<Slot>, std::greater<>> queue_;
+    std::uint64_t next_version_ = 0;
+    bool dirty_ = false; // Some coin's inputs changed since the intervals were last computed.
+    double tokens_;
+    double refilled_at_ = std::numeric_limits<double>::quiet_NaN();
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <utility>
+
+/// @brief Publishes immutable snapshots of a value between threads (RCU-style).
+/// Writers build a complete new value off to the side and swap it in atomically.
+/// Readers grab a shared pointer once and keep that consistent version alive for as long as they hold it,
+/// so a worker thread can never mutate data the render thread is currently drawing.
+template <typename T>
+class SnapshotSlot {
+public:
+    using Ptr = std::shared_ptr<const T>;
+
+    SnapshotSlot() : current_(std::make_shared<const T>()) {}
+
+    /// @brief Returns the currently published version. Never null.
+    Ptr load() const {
+        return current_.load(std::memory_order_acquire);
+    }
+
+    /// @brief Unconditionally replaces the published version.
+    void publish(Ptr next) {
+        current_.store(std::move(next), std::memory_order_release);
+    }
+
+    /// @brief Convenience overload that takes ownership of a freshly built value.
+    void publish(T value) {
+        publish(std::make_shared<const T>(std::move(value)));
+    }
+
+    /// @brief Read-copy-update: copies the current version, lets `fn` modify the copy and publishes it.
+    /// Retries if another writer published in between, so no update is ever lost.
+    /// @param fn Callable taking `T&`; returning false aborts the update without publishing.
+    /// @return True if a new version was published.
+    template <typename Fn>
+    bool update(Fn&& fn) {
+        Ptr expected = load();
+        while(true) {
+            auto next = std::make_shared<T>(*expected);
+            if(!fn(*next)) return false;
+            if(current_.compare_exchange_strong(expected, Ptr(std::move(next)), std::memory_order_acq_rel)) {
+                return true;
+            }
+            // `expected` now holds the version that beat us; rebuild on top of it.
+        }
+    }
+
+private:
+    std::atomic<std::shared_ptr<const T>> current_;
+};
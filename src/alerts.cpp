@@ -0,0 +1,296 @@
+#include "alerts.hpp"
+#include <algorithm>
+#include <cmath>
+#include <format>
+
+namespace {
+
+void erase_rule(std::multimap<double, std::uint64_t>& index, double key, std::uint64_t id) {
+    auto [first, last] = index.equal_range(key);
+    for(auto it = first; it != last; ++it) {
+        if(it->second == id) {
+            index.erase(it);
+            return;
+        }
+    }
+}
+
+} // namespace
+
+const char* alert_kind_name(AlertKind kind) {
+    switch(kind) {
+        case AlertKind::PriceAbove:   return "price_above";
+        case AlertKind::PriceBelow:   return "price_below";
+        case AlertKind::PercentMove:  return "percent_move";
+        case AlertKind::SmaCrossUp:   return "sma_cross_up";
+        case AlertKind::SmaCrossDown: return "sma_cross_down";
+    }
+    return "price_above";
+}
+
+std::optional<AlertKind> parse_alert_kind(std::string_view name) {
+    for(auto kind : {AlertKind::PriceAbove, AlertKind::PriceBelow, AlertKind::PercentMove, AlertKind::SmaCrossUp, AlertKind::SmaCrossDown}) {
+        if(name == alert_kind_name(kind)) return kind;
+    }
+    return std::nullopt;
+}
+
+std::uint64_t AlertEngine::add_rule(AlertRule rule, bool restored) {
+    std::lock_guard lock(mutex_);
+
+    if(rule.id == 0 || rules_.contains(rule.id)) {
+        rule.id = next_id_;
+    }
+    next_id_ = std::max(next_id_, rule.id + 1);
+    rule.short_period = std::max(rule.short_period, 1);
+    rule.long_period = std::max(rule.long_period, rule.short_period + 1);
+
+    CoinIndex& coin = index_[rule.coin_id];
+    // The same bounds as a crossing in on_price, so a level the price sits exactly on counts as reached.
+    bool past = false;
+    switch(rule.kind) {
+        case AlertKind::PriceAbove:
+            coin.above.emplace(rule.threshold, rule.id);
+            past = coin.last_price && rule.threshold <= *coin.last_price;
+            break;
+        case AlertKind::PriceBelow:
+            coin.below.emplace(rule.threshold, rule.id);
+            past = coin.last_price && rule.threshold >= *coin.last_price;
+            break;
+        case AlertKind::PercentMove:
+            coin.moves[rule.window_seconds].emplace(std::abs(rule.threshold), rule.id);
+            break;
+        case AlertKind::SmaCrossUp:
+        case AlertKind::SmaCrossDown: {
+            auto [pair, inserted] = coin.crossovers.try_emplace({rule.short_period, rule.long_period});
+            if(inserted) {
+                use_sma_window_locked(coin, rule.short_period);
+                use_sma_window_locked(coin, rule.long_period);
+            }
+            (rule.kind == AlertKind::SmaCrossUp ? pair->second.up : pair->second.down).push_back(rule.id);
+            break;
+        }
+    }
+
+    std::uint64_t id = rule.id;
+    auto stored = rules_.emplace(id, std::move(rule)).first;
+    if(restored) {
+        restored_.insert(id);
+    } else if(past) {
+        fire_locked(stored->second, *coin.last_price, coin.history.back().first);
+    }
+    return id;
+}
+
+bool AlertEngine::remove_rule(std::uint64_t id) {
+    std::lock_guard lock(mutex_);
+
+    auto it = rules_.find(id);
+    if(it == rules_.end()) return false;
+    const AlertRule& rule = it->second;
+
+    auto coin_it = index_.find(rule.coin_id);
+    if(coin_it != index_.end()) {
+        CoinIndex& coin = coin_it->second;
+        switch(rule.kind) {
+            case AlertKind::PriceAbove:
+                erase_rule(coin.above, rule.threshold, id);
+                break;
+            case AlertKind::PriceBelow:
+                erase_rule(coin.below, rule.threshold, id);
+                break;
+            case AlertKind::PercentMove: {
+                auto window = coin.moves.find(rule.window_seconds);
+                if(window != coin.moves.end()) {
+                    erase_rule(window->second, std::abs(rule.threshold), id);
+                    if(window->second.empty()) {
+                        coin.last_move.erase(window->first);
+                        coin.moves.erase(window);
+                    }
+                }
+                break;
+            }
+            case AlertKind::SmaCrossUp:
+            case AlertKind::SmaCrossDown: {
+                auto pair = coin.crossovers.find({rule.short_period, rule.long_period});
+                if(pair != coin.crossovers.end()) {
+                    std::erase(rule.kind == AlertKind::SmaCrossUp ? pair->second.up : pair->second.down, id);
+                    if(pair->second.up.empty() && pair->second.down.empty()) {
+                        coin.crossovers.erase(pair);
+                        release_sma_window_locked(coin, rule.short_period);
+                        release_sma_window_locked(coin, rule.long_period);
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    restored_.erase(id);
+    rules_.erase(it);
+    return true;
+}
+
+std::vector<AlertRule> AlertEngine::rules() const {
+    std::lock_guard lock(mutex_);
+    std::vector<AlertRule> result;
+    result.reserve(rules_.size());
+    for(auto const& [id, rule] : rules_) {
+        result.push_back(rule);
+    }
+    std::sort(result.begin(), result.end(), [](auto const& a, auto const& b) { return a.id < b.id; });
+    return result;
+}
+
+std::vector<AlertRule> AlertEngine::rules_for(const std::string& coin_id) const {
+    std::vector<AlertRule> result = rules();
+    std::erase_if(result, [&](auto const& rule) { return rule.coin_id != coin_id; });
+    return result;
+}
+
+std::size_t AlertEngine::rule_count() const {
+    std::lock_guard lock(mutex_);
+    return rules_.size();
+}
+
+void AlertEngine::on_prices(const std::map<std::string, double>& prices, double timestamp) {
+    for(auto const& [coin_id, price] : prices) {
+        on_price(coin_id, price, timestamp);
+    }
+}
+
+void AlertEngine::on_price(const std::string& coin_id, double price, double timestamp) {
+    if(!(price > 0.0)) return;
+
+    std::lock_guard lock(mutex_);
+    // Every coin keeps its last price, so a rule added later can be checked against it.
+    CoinIndex& coin = index_[coin_id];
+
+    // Level crossings: only the thresholds between the previous and the new price are visited.
+    // Without a previous price, every level the price is already past counts as crossed, except for
+    // restored rules, which only fire on a crossing.
+    if(!coin.last_price) {
+        for(auto r = coin.above.begin(), end = coin.above.upper_bound(price); r != end; ++r) {
+            if(!restored_.contains(r->second)) fire_locked(rules_.at(r->second), price, timestamp);
+        }
+        for(auto r = coin.below.lower_bound(price); r != coin.below.end(); ++r) {
+            if(!restored_.contains(r->second)) fire_locked(rules_.at(r->second), price, timestamp);
+        }
+    } else {
+        double last = *coin.last_price;
+        if(price > last) {
+            for(auto r = coin.above.upper_bound(last), end = coin.above.upper_bound(price); r != end; ++r) {
+                fire_locked(rules_.at(r->second), price, timestamp);
+            }
+        } else if(price < last) {
+            for(auto r = coin.below.lower_bound(price), end = coin.below.lower_bound(last); r != end; ++r) {
+                fire_locked(rules_.at(r->second), price, timestamp);
+            }
+        }
+    }
+    coin.last_price = price;
+
+    coin.history.emplace_back(timestamp, price);
+    for(auto& [period, window] : coin.sma_windows) {
+        window.sum += price;
+        if(coin.history.size() > static_cast<std::size_t>(period)) {
+            window.sum -= coin.history[coin.history.size() - 1 - period].second;
+        }
+    }
+    trim_history_locked(coin, timestamp);
+
+    // Percent moves: one reference lookup per distinct window, then the same range walk over sorted thresholds.
+    for(auto& [window, thresholds] : coin.moves) {
+        auto ref = std::lower_bound(coin.history.begin(), coin.history.end(), timestamp - window,
+            [](auto const& sample, double t) { return sample.first < t; });
+        if(ref == coin.history.end() || ref->second <= 0.0) continue;
+
+        double move = std::abs(price / ref->second - 1.0) * 100.0;
+        double& previous = coin.last_move[window];
+        if(move > previous) {
+            for(auto r = thresholds.upper_bound(previous), end = thresholds.upper_bound(move); r != end; ++r) {
+                fire_locked(rules_.at(r->second), price, timestamp);
+            }
+        }
+        previous = move;
+    }
+
+    // Crossovers: the averages before this tick follow from swapping the new price for the one that just left the window.
+    std::size_t size = coin.history.size();
+    for(auto const& [periods, rules] : coin.crossovers) {
+        auto [short_period, long_period] = periods;
+        if(size < static_cast<std::size_t>(long_period) + 1) continue;
+
+        double short_sum = coin.sma_windows.at(short_period).sum;
+        double long_sum = coin.sma_windows.at(long_period).sum;
+        double short_before = short_sum - price + coin.history[size - 1 - short_period].second;
+        double long_before = long_sum - price + coin.history[size - 1 - long_period].second;
+        double now = short_sum / short_period - long_sum / long_period;
+        double before = short_before / short_period - long_before / long_period;
+
+        if(before <= 0.0 && now > 0.0) {
+            for(auto id : rules.up) fire_locked(rules_.at(id), price, timestamp);
+        } else if(before >= 0.0 && now < 0.0) {
+            for(auto id : rules.down) fire_locked(rules_.at(id), price, timestamp);
+        }
+    }
+}
+
+std::vector<FiredAlert> AlertEngine::drain_fired() {
+    std::lock_guard lock(mutex_);
+    std::vector<FiredAlert> result;
+    result.swap(fired_);
+    return result;
+}
+
+void AlertEngine::fire_locked(const AlertRule& rule, double price, double timestamp) {
+    std::string message;
+    switch(rule.kind) {
+        case AlertKind::PriceAbove:
+            message = std::format("{} rose above {:.2f} (now {:.2f})", rule.coin_id, rule.threshold, price);
+            break;
+        case AlertKind::PriceBelow:
+            message = std::format("{} fell below {:.2f} (now {:.2f})", rule.coin_id, rule.threshold, price);
+            break;
+        case AlertKind::PercentMove:
+            message = std::format("{} moved {:.2f}% within {} min (now {:.2f})", rule.coin_id, std::abs(rule.threshold), rule.window_seconds / 60, price);
+            break;
+        case AlertKind::SmaCrossUp:
+            message = std::format("{} SMA-{} crossed above SMA-{}", rule.coin_id, rule.short_period, rule.long_period);
+            break;
+        case AlertKind::SmaCrossDown:
+            message = std::format("{} SMA-{} crossed below SMA-{}", rule.coin_id, rule.short_period, rule.long_period);
+            break;
+    }
+    fired_.push_back({rule.id, rule.coin_id, price, timestamp, std::move(message)});
+}
+
+void AlertEngine::use_sma_window_locked(CoinIndex& coin, int period) {
+    SmaWindow& window = coin.sma_windows[period];
+    if(window.users++ > 0) return;
+    // A new period starts from the samples already kept.
+    std::size_t count = std::min(coin.history.size(), static_cast<std::size_t>(period));
+    for(std::size_t i = coin.history.size() - count; i < coin.history.size(); i++) {
+        window.sum += coin.history[i].second;
+    }
+}
+
+void AlertEngine::release_sma_window_locked(CoinIndex& coin, int period) {
+    auto it = coin.sma_windows.find(period);
+    if(it != coin.sma_windows.end() && --it->second.users == 0) {
+        coin.sma_windows.erase(it);
+    }
+}
+
+void AlertEngine::trim_history_locked(CoinIndex& coin, double now) const {
+    // Keep enough samples for the longest SMA and enough time for the longest percent-move window.
+    std::size_t keep_samples = 1;
+    if(!coin.sma_windows.empty()) {
+        keep_samples = static_cast<std::size_t>(coin.sma_windows.rbegin()->first) + 1;
+    }
+    double keep_seconds = coin.moves.empty() ? 0.0 : coin.moves.rbegin()->first;
+
+    while(coin.history.size() > keep_samples && coin.history.front().first < now - keep_seconds) {
+        coin.history.pop_front();
+    }
+}
@@ -0,0 +1,32 @@
+#include "alloc_counter.hpp"
+#include <cstdlib>
+#include <new>
+
+namespace {
+// Per thread, so the count needs no synchronisation and other threads' traffic stays out of it.
+thread_local std::uint64_t allocation_count = 0;
+}
+
+std::uint64_t heap_allocation_count() {
+    return allocation_count;
+}
+
+// Replacing the plain forms is enough: the array and nothrow forms forward to them by default.
+void* operator new(std::size_t size) {
+    ++allocation_count;
+    if(size == 0) size = 1;
+    while(true) {
+        if(void* p = std::malloc(size)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if(!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
@@ -1,6 +1,10 @@
 #include "analysis.hpp"
 #include <numeric>
 #include <limits>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
 
 std::vector<double> calculate_sma(const std::vector<double>& prices, int period) {
 
@@ -22,4 +26,229 @@ std::vector<double> calculate_sma(const std::vector<double>& prices, int period)
     }
 
     return sma;
-}
\ No newline at end of file
+}
+
+namespace {
+
+// Tile sizes for the covariance kernel: a tile of rows times a chunk of samples stays resident in L1/L2.
+constexpr std::size_t ASSET_TILE = 32;
+constexpr std::size_t TIME_CHUNK = 512;
+
+// Inverse of the standard normal CDF (Acklam's rational approximation, relative error < 1.2e-9).
+double normal_quantile(double p) {
+    static const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02, 1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02, 6.680131188771972e+01, -1.328068155288572e+01};
+    static const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00, -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00, 3.754408661907416e+00};
+    const double low = 0.02425;
+
+    if(p <= 0.0) return -std::numeric_limits<double>::infinity();
+    if(p >= 1.0) return std::numeric_limits<double>::infinity();
+    if(p < low) {
+        double q = std::sqrt(-2 * std::log(p));
+        return (((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) / ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1);
+    }
+    if(p > 1 - low) {
+        double q = std::sqrt(-2 * std::log(1 - p));
+        return -(((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) / ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1);
+    }
+    double q = p - 0.5;
+    double r = q * q;
+    return (((((a[0]*r + a[1])*r + a[2])*r + a[3])*r + a[4])*r + a[5])*q / (((((b[0]*r + b[1])*r + b[2])*r + b[3])*r + b[4])*r + 1);
+}
+
+// Runs `fn(task)` for every task in [0, count) on up to `threads` workers, handing out tasks dynamically.
+template <typename Fn>
+void parallel_for(std::size_t count, unsigned threads, Fn&& fn) {
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, count));
+    if(threads <= 1) {
+        for(std::size_t task = 0; task < count; task++) fn(task);
+        return;
+    }
+
+    std::atomic<std::size_t> next{0};
+    auto worker = [&]() {
+        for(std::size_t task = next++; task < count; task = next++) fn(task);
+    };
+    std::vector<std::thread> pool;
+    for(unsigned t = 1; t < threads; t++) pool.emplace_back(worker);
+    worker();
+    for(auto& thread : pool) thread.join();
+}
+
+} // namespace
+
+std::vector<double> calculate_returns(const std::vector<double>& prices) {
+    std::vector<double> returns;
+    if(prices.size() < 2) return returns;
+
+    returns.reserve(prices.size() - 1);
+    for(size_t i = 1; i < prices.size(); i++) {
+        // A zero price would produce inf; treat it as no movement rather than poisoning every statistic.
+        returns.push_back(prices[i - 1] != 0.0 ? prices[i] / prices[i - 1] - 1.0 : 0.0);
+    }
+    return returns;
+}
+
+double calculate_volatility(const std::vector<double>& prices) {
+    if(prices.size() < 3) return 0.0;
+
+    // Welford's update, so the returns never need to be materialised.
+    double mean = 0.0;
+    double m2 = 0.0;
+    std::size_t n = 0;
+    for(size_t i = 1; i < prices.size(); i++) {
+        double r = prices[i - 1] != 0.0 ? prices[i] / prices[i - 1] - 1.0 : 0.0;
+        ++n;
+        double delta = r - mean;
+        mean += delta / static_cast<double>(n);
+        m2 += delta * (r - mean);
+    }
+    return std::sqrt(m2 / static_cast<double>(n - 1));
+}
+
+void downsample_lttb(const double* values, std::size_t count, std::size_t target, std::vector<double>& out) {
+    out.clear();
+    if(target >= count || target < 3) {
+        out.assign(values, values + count);
+        return;
+    }
+    out.reserve(target);
+
+    // Interior points are split into target - 2 buckets; from each we keep the point forming the largest
+    // triangle with the previously kept point and the average of the next bucket.
+    const double bucket = static_cast<double>(count - 2) / (target - 2);
+    std::size_t kept = 0;
+    out.push_back(values[0]);
+
+    for(std::size_t b = 0; b < target - 2; b++) {
+        std::size_t start = static_cast<std::size_t>(b * bucket) + 1;
+        std::size_t end = static_cast<std::size_t>((b + 1) * bucket) + 1;
+        std::size_t next_start = end;
+        std::size_t next_end = std::min(static_cast<std::size_t>((b + 2) * bucket) + 1, count);
+
+        double avg_x = 0.0;
+        double avg_y = 0.0;
+        for(std::size_t j = next_start; j < next_end; j++) {
+            avg_x += static_cast<double>(j);
+            avg_y += values[j];
+        }
+        std::size_t next_count = std::max<std::size_t>(next_end - next_start, 1);
+        avg_x /= next_count;
+        avg_y /= next_count;
+
+        double best_area = -1.0;
+        std::size_t best = start;
+        for(std::size_t j = start; j < end; j++) {
+            double area = std::abs((static_cast<double>(kept) - avg_x) * (values[j] - values[kept])
+                - (static_cast<double>(kept) - static_cast<double>(j)) * (avg_y - values[kept]));
+            if(area > best_area) {
+                best_area = area;
+                best = j;
+            }
+        }
+        out.push_back(values[best]);
+        kept = best;
+    }
+    out.push_back(values[count - 1]);
+}
+
+RiskReport calculate_risk(const std::vector<std::vector<double>>& returns, const std::vector<double>& weights, double confidence, unsigned threads) {
+    RiskReport report;
+    const std::size_t n = returns.size();
+    if(n == 0 || weights.size() != n) return report;
+
+    std::size_t samples = returns[0].size();
+    for(auto const& series : returns) samples = std::min(samples, series.size());
+    if(samples < 2) return report;
+
+    if(threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    report.assets = n;
+
+    // Centre each aligned series into one contiguous asset-major matrix so every dot product streams memory.
+    std::vector<double> centred(n * samples);
+    parallel_for(n, threads, [&](std::size_t i) {
+        const double* src = returns[i].data() + (returns[i].size() - samples);
+        double mean = std::accumulate(src, src + samples, 0.0) / samples;
+        double* dst = centred.data() + i * samples;
+        for(std::size_t t = 0; t < samples; t++) dst[t] = src[t] - mean;
+    });
+
+    // Covariance = X * X^T / (T - 1), computed over upper-triangle tiles. Each tile accumulates over
+    // time chunks so its rows are reused from cache instead of being re-streamed for every pair.
+    report.covariance.assign(n * n, 0.0);
+    const std::size_t tiles = (n + ASSET_TILE - 1) / ASSET_TILE;
+    std::vector<std::pair<std::size_t, std::size_t>> tile_pairs;
+    for(std::size_t bi = 0; bi < tiles; bi++)
+        for(std::size_t bj = bi; bj < tiles; bj++)
+            tile_pairs.emplace_back(bi, bj);
+
+    parallel_for(tile_pairs.size(), threads, [&](std::size_t task) {
+        auto [bi, bj] = tile_pairs[task];
+        std::size_t i_end = std::min(n, (bi + 1) * ASSET_TILE);
+        std::size_t j_end = std::min(n, (bj + 1) * ASSET_TILE);
+        double acc[ASSET_TILE][ASSET_TILE] = {};
+
+        for(std::size_t t0 = 0; t0 < samples; t0 += TIME_CHUNK) {
+            std::size_t t1 = std::min(samples, t0 + TIME_CHUNK);
+            for(std::size_t i = bi * ASSET_TILE; i < i_end; i++) {
+                const double* xi = centred.data() + i * samples;
+                for(std::size_t j = std::max(i, bj * ASSET_TILE); j < j_end; j++) {
+                    const double* xj = centred.data() + j * samples;
+                    double sum = 0.0;
+                    for(std::size_t t = t0; t < t1; t++) sum += xi[t] * xj[t];
+                    acc[i - bi * ASSET_TILE][j - bj * ASSET_TILE] += sum;
+                }
+            }
+        }
+
+        // Tiles never overlap, so each thread writes its own cells (and their mirror) without locking.
+        for(std::size_t i = bi * ASSET_TILE; i < i_end; i++) {
+            for(std::size_t j = std::max(i, bj * ASSET_TILE); j < j_end; j++) {
+                double cov = acc[i - bi * ASSET_TILE][j - bj * ASSET_TILE] / (samples - 1);
+                report.covariance[i * n + j] = cov;
+                report.covariance[j * n + i] = cov;
+            }
+        }
+    });
+
+    report.volatility.resize(n);
+    for(std::size_t i = 0; i < n; i++) report.volatility[i] = std::sqrt(report.covariance[i * n + i]);
+
+    report.correlation.resize(n * n);
+    for(std::size_t i = 0; i < n; i++) {
+        for(std::size_t j = 0; j < n; j++) {
+            double denom = report.volatility[i] * report.volatility[j];
+            report.correlation[i * n + j] = denom > 0.0 ? report.covariance[i * n + j] / denom : (i == j ? 1.0 : 0.0);
+        }
+    }
+
+    double weight_sum = std::accumulate(weights.begin(), weights.end(), 0.0);
+    if(weight_sum <= 0.0) return report;
+    std::vector<double> w(n);
+    for(std::size_t i = 0; i < n; i++) w[i] = weights[i] / weight_sum;
+
+    // Portfolio variance w^T C w.
+    double variance = 0.0;
+    for(std::size_t i = 0; i < n; i++) {
+        double row = 0.0;
+        for(std::size_t j = 0; j < n; j++) row += report.covariance[i * n + j] * w[j];
+        variance += w[i] * row;
+    }
+    report.portfolio_volatility = std::sqrt(std::max(variance, 0.0));
+
+    // Historical VaR from the empirical portfolio return distribution (uses raw, not centred, returns).
+    std::vector<double> portfolio(samples, 0.0);
+    for(std::size_t i = 0; i < n; i++) {
+        const double* src = returns[i].data() + (returns[i].size() - samples);
+        for(std::size_t t = 0; t < samples; t++) portfolio[t] += w[i] * src[t];
+    }
+    double mean = std::accumulate(portfolio.begin(), portfolio.end(), 0.0) / samples;
+
+    std::size_t k = static_cast<std::size_t>(std::floor((1.0 - confidence) * (samples - 1)));
+    std::nth_element(portfolio.begin(), portfolio.begin() + k, portfolio.end());
+    report.var_historical = std::max(0.0, -portfolio[k]);
+
+    report.var_parametric = std::max(0.0, normal_quantile(confidence) * report.portfolio_volatility - mean);
+    return report;
+}
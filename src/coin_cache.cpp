@@ -0,0 +1,84 @@
+#include "coin_cache.hpp"
+
+CoinCache::CoinCache(std::size_t budget_bytes) : budget_(budget_bytes) {}
+
+std::shared_ptr<const CoinData> CoinCache::get(const std::string& coin_id) {
+    std::lock_guard lock(mutex_);
+    auto it = index_.find(coin_id);
+    if(it == index_.end()) return nullptr;
+
+    // Move the hit to the front without reallocating the node.
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return it->second->data;
+}
+
+bool CoinCache::contains(const std::string& coin_id) const {
+    std::lock_guard lock(mutex_);
+    return index_.contains(coin_id);
+}
+
+void CoinCache::put(std::shared_ptr<const CoinData> data) {
+    if(!data || data->id.empty()) return;
+
+    std::size_t bytes = approx_bytes(*data);
+    std::lock_guard lock(mutex_);
+
+    auto it = index_.find(data->id);
+    if(it != index_.end()) {
+        used_ -= it->second->bytes;
+        it->second->data = std::move(data);
+        it->second->bytes = bytes;
+        lru_.splice(lru_.begin(), lru_, it->second);
+    } else {
+        std::string id = data->id;
+        lru_.push_front({id, std::move(data), bytes});
+        index_[id] = lru_.begin();
+    }
+    used_ += bytes;
+    evict_locked();
+}
+
+void CoinCache::erase(const std::string& coin_id) {
+    std::lock_guard lock(mutex_);
+    auto it = index_.find(coin_id);
+    if(it == index_.end()) return;
+
+    used_ -= it->second->bytes;
+    lru_.erase(it->second);
+    index_.erase(it);
+}
+
+std::vector<std::shared_ptr<const CoinData>> CoinCache::entries() const {
+    std::lock_guard lock(mutex_);
+    std::vector<std::shared_ptr<const CoinData>> result;
+    result.reserve(lru_.size());
+    for(auto const& entry : lru_) {
+        result.push_back(entry.data);
+    }
+    return result;
+}
+
+std::size_t CoinCache::size() const {
+    std::lock_guard lock(mutex_);
+    return lru_.size();
+}
+
+std::size_t CoinCache::bytes_used() const {
+    std::lock_guard lock(mutex_);
+    return used_;
+}
+
+std::size_t CoinCache::approx_bytes(const CoinData& data) {
+    std::size_t doubles = data.price_history.capacity() + data.history_time.capacity() + data.time.capacity() + data.open.capacity()
+        + data.high.capacity() + data.low.capacity() + data.close.capacity();
+    return sizeof(CoinData) + data.id.capacity() + doubles * sizeof(double);
+}
+
+void CoinCache::evict_locked() {
+    while(used_ > budget_ && lru_.size() > 1) {
+        Entry& victim = lru_.back();
+        used_ -= victim.bytes;
+        index_.erase(victim.id);
+        lru_.pop_back();
+    }
+}
@@ -0,0 +1,179 @@
+#include "market_client.hpp"
+#include "persistence.hpp"
+#include "analysis.hpp"
+#include "logger.hpp"
+#include "ledger.hpp"
+#include "price_provider.hpp"
+#include "refresh_scheduler.hpp"
+#include "price_board.hpp"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Headless collector: fetches prices and histories once per host and publishes them on the
+// shared-memory price board, where every local MarketTracker instance and script can read them.
+// Usage: PriceCollector [vs_currency ...]   (default: usd eur ils btc)
+
+static std::atomic<bool> running{true};
+
+static void request_stop(int) {
+    running.store(false);
+}
+
+static double now_seconds() {
+    return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char** argv) {
+    // A separate file, so the collector never rotates a dashboard's log from under it.
+    LoggerOptions log_options;
+    log_options.path = "collector.log";
+    app_logger().start(log_options);
+    std::signal(SIGINT, request_stop);
+    std::signal(SIGTERM, request_stop);
+
+    auto board = PriceBoardWriter::create();
+    if(!board) {
+        app_logger().stop();
+        return 1;
+    }
+
+    std::vector<std::string> currencies;
+    for(int i = 1; i < argc; i++) {
+        currencies.emplace_back(argv[i]);
+    }
+    if(currencies.empty()) {
+        currencies = {"usd", "eur", "ils", "btc"};
+    }
+
+    // Same provider setup as the dashboard, including the optional mirror to hedge against.
+    std::vector<std::shared_ptr<PriceProvider>> providers{std::make_shared<CoinGeckoProvider>()};
+    if(const char* mirror = std::getenv("TRACKER_MIRROR_URL")) {
+        providers.push_back(std::make_shared<CoinGeckoProvider>(mirror, "mirror"));
+    }
+    HedgedPriceSource price_source(std::move(providers));
+    MarketClient client;
+    // One collector stands in for every dashboard on the host, within the budget of a single dashboard.
+    RefreshScheduler scheduler;
+
+    // The watchlist and holdings are edited in the dashboards, so they are re-read from disk periodically.
+    double const RELOAD_INTERVAL = 30.0;
+    // The 24h history has 5-minute points, so refetching it more often gains nothing.
+    double const HISTORY_INTERVAL = 300.0;
+
+    std::vector<CoinDef> coins;
+    std::map<std::string, PortfolioEntry> portfolio;
+    Ledger ledger;
+    double loaded_at = 0.0;
+
+    std::set<std::string> tracked;
+    std::map<std::string, double> prices;
+    std::map<std::string, std::shared_ptr<const CoinData>> histories;
+    std::map<std::string, double> history_fetched_at;
+
+    while(running.load()) {
+        double now = now_seconds();
+
+        if(now - loaded_at >= RELOAD_INTERVAL) {
+            loaded_at = now;
+            coins = load_coins();
+            portfolio = load_portfolio();
+            ledger = load_ledger();
+            for(auto const& coin_id : ledger.coins()) {
+                PositionState position = ledger.position(coin_id);
+                portfolio[coin_id] = {position.amount, position.average_cost()};
+            }
+
+            std::set<std::string> listed;
+            for(auto const& coin : coins) {
+                listed.insert(coin.api_id);
+                scheduler.track(coin.api_id, now);
+            }
+            for(auto it = tracked.begin(); it != tracked.end();) {
+                if(listed.contains(*it)) {
+                    ++it;
+                    continue;
+                }
+                scheduler.untrack(*it);
+                prices.erase(*it);
+                histories.erase(*it);
+                history_fetched_at.erase(*it);
+                it = tracked.erase(it);
+            }
+            tracked.merge(listed);
+        }
+
+        std::vector<std::string> due = scheduler.take_due(now);
+        if(due.empty()) {
+            board->heartbeat(now);
+            std::this_thread::sleep_for(std::chrono::milliseconds(250));
+            continue;
+        }
+
+        PriceBatch batch = price_source.fetch_prices(due, currencies);
+        for(auto const& [id, price] : batch.prices) {
+            prices[id] = price;
+            board->publish_price(id, price, now);
+        }
+        if(batch.fx.currencies().size() > 1) {
+            std::map<std::string, double> rates;
+            for(int c = 0; c < static_cast<int>(batch.fx.currencies().size()); c++) {
+                rates[batch.fx.currencies()[c]] = batch.fx.rate(0, c);
+            }
+            board->publish_fx(rates);
+        }
+
+        // Histories ride along with the price refresh when they are old enough and the budget allows.
+        for(auto const& id : due) {
+            auto fetched = history_fetched_at.find(id);
+            if(fetched != history_fetched_at.end() && now - fetched->second < HISTORY_INTERVAL) continue;
+            // A known coin only needs the history delta; its price just came with the batch.
+            auto previous = histories[id];
+            auto price = batch.prices.find(id);
+            bool delta = previous && price != batch.prices.end();
+            if(!scheduler.try_spend(now, delta ? 1.0 : 2.0)) break;
+
+            auto data = delta ? client.refresh_coin_data(*previous, price->second) : client.get_coin_data(id);
+            history_fetched_at[id] = now;
+            if(!data) continue;
+
+            board->publish_history(id, data->history_time, data->price_history);
+            scheduler.set_volatility(id, calculate_volatility(data->price_history));
+            histories[id] = std::make_shared<const CoinData>(std::move(*data));
+        }
+
+        PortfolioValuation valuation;
+        valuation.updated_at = now;
+        for(auto const& coin_id : ledger.coins()) {
+            valuation.realized_pnl += ledger.position(coin_id).realized_pnl;
+        }
+        for(auto const& coin : coins) {
+            auto entry = portfolio.find(coin.api_id);
+            auto quote = prices.find(coin.api_id);
+            if(entry == portfolio.end() || quote == prices.end()) continue;
+            valuation.net_worth += entry->second.amount * quote->second;
+            valuation.cost_basis += entry->second.amount * entry->second.buyPrice;
+        }
+        for(auto const& coin : coins) {
+            auto entry = portfolio.find(coin.api_id);
+            auto quote = prices.find(coin.api_id);
+            double value = entry != portfolio.end() && quote != prices.end() ? entry->second.amount * quote->second : 0.0;
+            scheduler.set_weight(coin.api_id, valuation.net_worth > 0.0 ? value / valuation.net_worth : 0.0);
+        }
+        board->publish_valuation(valuation);
+        board->commit(now);
+        LOG_DEBUG("Published {} prices", batch.prices.size());
+    }
+
+    LOG_INFO("Collector stopping");
+    board.reset();
+    app_logger().stop();
+    return 0;
+}
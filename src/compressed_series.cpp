@@ -0,0 +1,242 @@
+#include "compressed_series.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Reads a most-significant-bit-first stream written by CompressedSeries::write_bits.
+struct BitReader {
+    const std::vector<std::uint64_t>& words;
+    std::size_t pos = 0;
+
+    std::uint64_t read(int bits) {
+        std::size_t word = pos / 64;
+        int offset = static_cast<int>(pos % 64);
+        int avail = 64 - offset;
+        pos += bits;
+
+        std::uint64_t result = (words[word] << offset) >> (64 - bits);
+        if(bits > avail) {
+            // The value straddles two words; pull the remaining low bits from the next one.
+            int spill = bits - avail;
+            result |= words[word + 1] >> (64 - spill);
+        }
+        return result;
+    }
+};
+
+} // namespace
+
+CompressedSeries::CompressedSeries(std::size_t block_size) : block_size_(std::max<std::size_t>(block_size, 2)) {}
+
+void CompressedSeries::write_bits(Block& block, std::uint64_t value, int bits) {
+    if(bits < 64) value &= (std::uint64_t{1} << bits) - 1;
+
+    int offset = static_cast<int>(block.bit_count % 64);
+    if(offset == 0) block.words.push_back(0);
+    int free = 64 - offset;
+
+    if(bits <= free) {
+        block.words.back() |= value << (free - bits);
+    } else {
+        int spill = bits - free;
+        block.words.back() |= value >> spill;
+        block.words.push_back(value << (64 - spill));
+    }
+    block.bit_count += bits;
+}
+
+bool CompressedSeries::append(std::int64_t timestamp, double value) {
+    if(count_ > 0 && timestamp < prev_time_) return false;
+
+    std::uint64_t bits = std::bit_cast<std::uint64_t>(value);
+
+    // Start a new block: the first point is stored raw so each block decodes independently.
+    if(blocks_.empty() || blocks_.back().count >= block_size_) {
+        if(!blocks_.empty()) blocks_.back().words.shrink_to_fit();
+
+        Block& block = blocks_.emplace_back();
+        block.first_time = block.last_time = timestamp;
+        block.min = block.max = value;
+        block.count = 1;
+        write_bits(block, static_cast<std::uint64_t>(timestamp), 64);
+        write_bits(block, bits, 64);
+
+        prev_time_ = timestamp;
+        prev_delta_ = 0;
+        prev_bits_ = bits;
+        prev_leading_ = -1;
+        ++count_;
+        return true;
+    }
+
+    Block& block = blocks_.back();
+
+    // Timestamp: delta-of-delta, bucketed by magnitude. Regular sampling costs a single bit.
+    std::int64_t delta = timestamp - prev_time_;
+    std::int64_t dod = delta - prev_delta_;
+    if(dod == 0) {
+        write_bits(block, 0b0, 1);
+    } else if(dod >= -63 && dod <= 64) {
+        write_bits(block, 0b10, 2);
+        write_bits(block, static_cast<std::uint64_t>(dod + 63), 7);
+    } else if(dod >= -255 && dod <= 256) {
+        write_bits(block, 0b110, 3);
+        write_bits(block, static_cast<std::uint64_t>(dod + 255), 9);
+    } else if(dod >= -2047 && dod <= 2048) {
+        write_bits(block, 0b1110, 4);
+        write_bits(block, static_cast<std::uint64_t>(dod + 2047), 12);
+    } else {
+        write_bits(block, 0b1111, 4);
+        write_bits(block, static_cast<std::uint64_t>(dod), 64);
+    }
+
+    // Value: XOR against the previous value, storing only the meaningful bits.
+    std::uint64_t x = bits ^ prev_bits_;
+    if(x == 0) {
+        write_bits(block, 0b0, 1);
+    } else {
+        int leading = std::min(std::countl_zero(x), 31); // Must fit in 5 bits.
+        int trailing = std::countr_zero(x);
+
+        if(prev_leading_ >= 0 && leading >= prev_leading_ && trailing >= prev_trailing_) {
+            // Reuse the previous window; no need to store its bounds again.
+            write_bits(block, 0b10, 2);
+            write_bits(block, x >> prev_trailing_, 64 - prev_leading_ - prev_trailing_);
+        } else {
+            int meaningful = 64 - leading - trailing;
+            write_bits(block, 0b11, 2);
+            write_bits(block, static_cast<std::uint64_t>(leading), 5);
+            write_bits(block, static_cast<std::uint64_t>(meaningful - 1), 6);
+            write_bits(block, x >> trailing, meaningful);
+            prev_leading_ = leading;
+            prev_trailing_ = trailing;
+        }
+    }
+
+    block.last_time = timestamp;
+    if(!std::isnan(value)) {
+        block.min = std::isnan(block.min) ? value : std::min(block.min, value);
+        block.max = std::isnan(block.max) ? value : std::max(block.max, value);
+    }
+    ++block.count;
+
+    prev_time_ = timestamp;
+    prev_delta_ = delta;
+    prev_bits_ = bits;
+    ++count_;
+    return true;
+}
+
+void CompressedSeries::decode_block(const Block& block, std::int64_t from, std::int64_t to, std::vector<double>& times, std::vector<double>& values) const {
+    BitReader reader{block.words};
+    std::int64_t t = static_cast<std::int64_t>(reader.read(64));
+    std::uint64_t v = reader.read(64);
+    std::int64_t delta = 0;
+    int leading = 0;
+    int trailing = 0;
+
+    for(std::uint32_t i = 0; ; ++i) {
+        if(t > to) return;
+        if(t >= from) {
+            times.push_back(static_cast<double>(t));
+            values.push_back(std::bit_cast<double>(v));
+        }
+        if(i + 1 >= block.count) return;
+
+        std::int64_t dod;
+        if(!reader.read(1))      dod = 0;
+        else if(!reader.read(1)) dod = static_cast<std::int64_t>(reader.read(7)) - 63;
+        else if(!reader.read(1)) dod = static_cast<std::int64_t>(reader.read(9)) - 255;
+        else if(!reader.read(1)) dod = static_cast<std::int64_t>(reader.read(12)) - 2047;
+        else                     dod = static_cast<std::int64_t>(reader.read(64));
+        delta += dod;
+        t += delta;
+
+        if(reader.read(1)) {
+            if(reader.read(1)) {
+                leading = static_cast<int>(reader.read(5));
+                int meaningful = static_cast<int>(reader.read(6)) + 1;
+                trailing = 64 - leading - meaningful;
+            }
+            v ^= reader.read(64 - leading - trailing) << trailing;
+        }
+    }
+}
+
+void CompressedSeries::decode(std::vector<double>& times, std::vector<double>& values) const {
+    times.clear();
+    values.clear();
+    times.reserve(count_);
+    values.reserve(count_);
+    for(auto const& block : blocks_) {
+        decode_block(block, std::numeric_limits<std::int64_t>::min(), std::numeric_limits<std::int64_t>::max(), times, values);
+    }
+}
+
+void CompressedSeries::decode_range(std::int64_t from, std::int64_t to, std::vector<double>& times, std::vector<double>& values) const {
+    times.clear();
+    values.clear();
+    for(auto const& block : blocks_) {
+        if(block.last_time < from) continue;
+        if(block.first_time > to) break;
+        decode_block(block, from, to, times, values);
+    }
+}
+
+std::optional<std::pair<double, double>> CompressedSeries::min_max(std::int64_t from, std::int64_t to) const {
+    std::optional<std::pair<double, double>> result;
+    auto merge = [&](double lo, double hi) {
+        if(std::isnan(lo) || std::isnan(hi)) return;
+        if(!result) result = std::pair{lo, hi};
+        else result = std::pair{std::min(result->first, lo), std::max(result->second, hi)};
+    };
+
+    std::vector<double> times;
+    std::vector<double> values;
+    for(auto const& block : blocks_) {
+        if(block.last_time < from) continue;
+        if(block.first_time > to) break;
+
+        if(block.first_time >= from && block.last_time <= to) {
+            // Fully covered: the block summary is enough.
+            merge(block.min, block.max);
+        } else {
+            times.clear();
+            values.clear();
+            decode_block(block, from, to, times, values);
+            for(double v : values) merge(v, v);
+        }
+    }
+    return result;
+}
+
+std::size_t CompressedSeries::bytes() const {
+    std::size_t total = sizeof(*this) + blocks_.capacity() * sizeof(Block);
+    for(auto const& block : blocks_) {
+        total += block.words.capacity() * sizeof(std::uint64_t);
+    }
+    return total;
+}
+
+std::optional<std::int64_t> CompressedSeries::first_time() const {
+    if(blocks_.empty()) return std::nullopt;
+    return blocks_.front().first_time;
+}
+
+std::optional<std::int64_t> CompressedSeries::last_time() const {
+    if(blocks_.empty()) return std::nullopt;
+    return blocks_.back().last_time;
+}
+
+void CompressedSeries::clear() {
+    blocks_.clear();
+    count_ = 0;
+    prev_time_ = 0;
+    prev_delta_ = 0;
+    prev_bits_ = 0;
+    prev_leading_ = -1;
+    prev_trailing_ = 0;
+}
@@ -1,4 +1,5 @@
 #include "custom_plots.hpp"
+#include "analysis.hpp"
 #include <implot.h>
 #include <imgui.h>
 #include <algorithm> // For std::min, std::max
@@ -56,4 +57,39 @@ void PlotCandlestick(const char* label_id, const double* xs, const double* opens
         }
         ImPlot::EndItem();
     }
+}
+
+void SparklineSet::build(const std::vector<std::vector<double>>& series, int points) {
+    points_per_line = std::max(points, 2);
+    values.assign(series.size() * points_per_line, 0.5f);
+
+    std::vector<double> scratch;
+    for(size_t line = 0; line < series.size(); line++) {
+        if(series[line].size() < 2) continue;
+
+        downsample_lttb(series[line].data(), series[line].size(), points_per_line, scratch);
+        auto [lo, hi] = std::minmax_element(scratch.begin(), scratch.end());
+        double range = *hi - *lo;
+
+        // Short series are stretched across the full width by nearest-point resampling.
+        float* dst = values.data() + line * points_per_line;
+        for(int i = 0; i < points_per_line; i++) {
+            size_t src = scratch.size() == static_cast<size_t>(points_per_line) ? i : i * (scratch.size() - 1) / (points_per_line - 1);
+            dst[i] = range > 0.0 ? static_cast<float>((scratch[src] - *lo) / range) : 0.5f;
+        }
+    }
+}
+
+void DrawSparkline(const float* values, int count, ImVec2 size, ImU32 color) {
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    ImGui::Dummy(size);
+    if(count < 2 || !ImGui::IsItemVisible()) return;
+
+    // One scratch buffer shared by every sparkline; it stops growing after the first frame.
+    static std::vector<ImVec2> points;
+    points.resize(count);
+    for(int i = 0; i < count; i++) {
+        points[i] = ImVec2(origin.x + size.x * i / (count - 1), origin.y + size.y * (1.0f - values[i]));
+    }
+    ImGui::GetWindowDrawList()->AddPolyline(points.data(), count, color, ImDrawFlags_None, 1.5f);
 }
\ No newline at end of file
@@ -0,0 +1,56 @@
+#include "fx.hpp"
+#include <algorithm>
+#include <utility>
+
+FxMatrix::FxMatrix(std::string base) : base_(std::move(base)), currencies_{base_}, matrix_{1.0} {}
+
+FxMatrix FxMatrix::from_quotes(const std::map<std::string, std::map<std::string, double>>& quotes, const std::string& base) {
+    // Units of each currency per one unit of base, along with the base price that produced it.
+    std::map<std::string, std::pair<double, double>> best;
+
+    for(auto const& [coin, prices] : quotes) {
+        auto base_it = prices.find(base);
+        if(base_it == prices.end() || base_it->second <= 0.0) continue;
+        double base_price = base_it->second;
+
+        for(auto const& [currency, price] : prices) {
+            if(currency == base || price <= 0.0) continue;
+            auto& slot = best[currency];
+            if(base_price > slot.second) {
+                slot = {price / base_price, base_price};
+            }
+        }
+    }
+
+    FxMatrix fx(base);
+    std::vector<double> per_base{1.0};
+    for(auto const& [currency, entry] : best) {
+        fx.currencies_.push_back(currency);
+        per_base.push_back(entry.first);
+    }
+
+    std::size_t n = fx.currencies_.size();
+    fx.matrix_.assign(n * n, 0.0);
+    for(std::size_t from = 0; from < n; from++) {
+        for(std::size_t to = 0; to < n; to++) {
+            fx.matrix_[from * n + to] = per_base[to] / per_base[from];
+        }
+    }
+    return fx;
+}
+
+int FxMatrix::index_of(const std::string& currency) const {
+    auto it = std::find(currencies_.begin(), currencies_.end(), currency);
+    return it == currencies_.end() ? -1 : static_cast<int>(it - currencies_.begin());
+}
+
+double FxMatrix::rate(const std::string& from, const std::string& to) const {
+    int f = index_of(from);
+    int t = index_of(to);
+    if(f < 0 || t < 0) return 0.0;
+    return rate(f, t);
+}
+
+double FxMatrix::convert(double amount, const std::string& from, const std::string& to) const {
+    return amount * rate(from, to);
+}
@@ -0,0 +1,178 @@
+#include "json_stream.hpp"
+#include <charconv>
+#include <limits>
+
+namespace {
+
+bool is_number_char(char c) {
+    return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+} // namespace
+
+NumericRowStream::NumericRowStream(std::string key, RowCallback on_row)
+    : key_(std::move(key)), on_row_(std::move(on_row)) {}
+
+bool NumericRowStream::feed(std::string_view chunk) {
+    if(failed_) return false;
+
+    for(char c : chunk) {
+        switch(state_) {
+            case State::String:
+                if(c == '\\') state_ = State::StringEscape;
+                else if(c == '"') {
+                    state_ = State::Scan;
+                    if(capture_) {
+                        last_key_ = token_;
+                        capture_ = false;
+                    } else {
+                        end_value();
+                    }
+                } else if(capture_) {
+                    token_.push_back(c);
+                }
+                break;
+
+            case State::StringEscape:
+                // Escapes never matter for the keys we look for; keep the raw character.
+                if(capture_) token_.push_back(c);
+                state_ = State::String;
+                break;
+
+            case State::Number:
+                if(is_number_char(c)) {
+                    token_.push_back(c);
+                    break;
+                }
+                if(!finish_number()) return false;
+                state_ = State::Scan;
+                if(!scan(c)) return false;
+                break;
+
+            case State::Literal:
+                if(c >= 'a' && c <= 'z') {
+                    token_.push_back(c);
+                    break;
+                }
+                if(!finish_literal()) return false;
+                state_ = State::Scan;
+                if(!scan(c)) return false;
+                break;
+
+            case State::Scan:
+                if(!scan(c)) return false;
+                break;
+        }
+    }
+    return true;
+}
+
+bool NumericRowStream::scan(char c) {
+    if(is_space(c)) return true;
+
+    switch(c) {
+        case '{':
+        case '[':
+            open(c);
+            return true;
+        case '}':
+        case ']':
+            return close(c);
+        case ',':
+            if(!stack_.empty() && stack_.back() == '{') expect_key_ = true;
+            return true;
+        case ':':
+            return true;
+        case '"':
+            state_ = State::String;
+            // Only root-level keys are kept; every other string is skipped without copying.
+            capture_ = expect_key_ && stack_.size() == 1 && !key_.empty();
+            expect_key_ = false;
+            token_.clear();
+            return true;
+        default:
+            break;
+    }
+
+    if(is_number_char(c)) {
+        state_ = State::Number;
+        token_.assign(1, c);
+        return true;
+    }
+    if(c >= 'a' && c <= 'z') {
+        state_ = State::Literal;
+        token_.assign(1, c);
+        return true;
+    }
+    failed_ = true;
+    return false;
+}
+
+void NumericRowStream::open(char container) {
+    // The target is the root array, or the array value of `key_` directly inside the root object.
+    bool is_target = container == '[' && target_depth_ < 0 && !complete_ &&
+        (key_.empty() ? stack_.empty() : (stack_.size() == 1 && stack_.back() == '{' && last_key_ == key_));
+
+    stack_.push_back(container);
+    expect_key_ = container == '{';
+    if(is_target) {
+        target_depth_ = static_cast<int>(stack_.size());
+    } else if(in_row()) {
+        row_.clear();
+    }
+}
+
+bool NumericRowStream::close(char container) {
+    char expected = container == '}' ? '{' : '[';
+    if(stack_.empty() || stack_.back() != expected) {
+        failed_ = true;
+        return false;
+    }
+
+    if(in_row()) {
+        ++rows_;
+        if(on_row_) on_row_(row_);
+        row_.clear();
+    }
+    if(static_cast<int>(stack_.size()) == target_depth_) {
+        target_depth_ = -1;
+        complete_ = true;
+    }
+    stack_.pop_back();
+    end_value();
+    return true;
+}
+
+void NumericRowStream::end_value() {
+    if(!stack_.empty() && stack_.size() == 1) last_key_.clear();
+}
+
+bool NumericRowStream::in_row() const {
+    return target_depth_ >= 0 && static_cast<int>(stack_.size()) == target_depth_ + 1 && stack_.back() == '[';
+}
+
+bool NumericRowStream::finish_number() {
+    double value = 0.0;
+    auto [end, ec] = std::from_chars(token_.data(), token_.data() + token_.size(), value);
+    if(ec != std::errc() || end != token_.data() + token_.size()) {
+        failed_ = true;
+        return false;
+    }
+    if(in_row()) row_.push_back(value);
+    end_value();
+    return true;
+}
+
+bool NumericRowStream::finish_literal() {
+    if(token_ != "null" && token_ != "true" && token_ != "false") {
+        failed_ = true;
+        return false;
+    }
+    if(in_row()) row_.push_back(token_ == "null" ? std::numeric_limits<double>::quiet_NaN() : 0.0);
+    end_value();
+    return true;
+}
@@ -0,0 +1,185 @@
+#include "ledger.hpp"
+#include <algorithm>
+
+namespace {
+
+// Relative slack so selling the whole position never fails on floating-point residue.
+constexpr double AMOUNT_EPSILON = 1e-9;
+
+} // namespace
+
+const char* trade_side_name(TradeSide side) {
+    switch(side) {
+        case TradeSide::Buy:         return "Buy";
+        case TradeSide::Sell:        return "Sell";
+        case TradeSide::TransferIn:  return "Transfer In";
+        case TradeSide::TransferOut: return "Transfer Out";
+    }
+    return "Buy";
+}
+
+const char* cost_method_name(CostMethod method) {
+    switch(method) {
+        case CostMethod::Fifo:    return "fifo";
+        case CostMethod::Lifo:    return "lifo";
+        case CostMethod::Average: return "average";
+    }
+    return "fifo";
+}
+
+std::optional<CostMethod> parse_cost_method(std::string_view name) {
+    for(auto method : {CostMethod::Fifo, CostMethod::Lifo, CostMethod::Average}) {
+        if(name == cost_method_name(method)) return method;
+    }
+    return std::nullopt;
+}
+
+Ledger::Ledger(CostMethod method) : method_(method) {}
+
+bool Ledger::append(const Trade& trade) {
+    if(!(trade.amount > 0.0) || !(trade.price >= 0.0) || !(trade.fee >= 0.0)) return false;
+
+    auto existing = books_.find(trade.coin_id);
+    if(existing != books_.end() && trade.timestamp < existing->second.trades.time.back()) return false;
+
+    Book& book = existing != books_.end() ? existing->second : books_[trade.coin_id];
+    if(!apply(book, trade.side, trade.amount, trade.price, trade.fee)) {
+        if(book.trades.time.empty()) books_.erase(trade.coin_id);
+        return false;
+    }
+
+    book.trades.time.push_back(trade.timestamp);
+    book.trades.side.push_back(trade.side);
+    book.trades.amount.push_back(trade.amount);
+    book.trades.price.push_back(trade.price);
+    book.trades.fee.push_back(trade.fee);
+    ++count_;
+    return true;
+}
+
+double Ledger::take_lots(Book& book, double amount) {
+    double removed_cost = 0.0;
+    while(amount > 0.0 && !book.lots.empty()) {
+        // FIFO consumes the oldest lot, LIFO the newest; Average only ever holds one pooled lot.
+        Lot& lot = method_ == CostMethod::Lifo ? book.lots.back() : book.lots.front();
+        double taken = std::min(amount, lot.amount);
+        removed_cost += taken * lot.unit_cost;
+        lot.amount -= taken;
+        amount -= taken;
+        if(amount > 0.0 || lot.amount <= 0.0) {
+            if(method_ == CostMethod::Lifo) book.lots.pop_back();
+            else book.lots.pop_front();
+        }
+    }
+    return removed_cost;
+}
+
+bool Ledger::apply(Book& book, TradeSide side, double amount, double price, double fee) {
+    double held = book.held.empty() ? 0.0 : book.held.back();
+    double cost = book.cost.empty() ? 0.0 : book.cost.back();
+    double realized = book.realized.empty() ? 0.0 : book.realized.back();
+    double fees = (book.fees.empty() ? 0.0 : book.fees.back()) + fee;
+
+    switch(side) {
+        case TradeSide::Buy:
+        case TradeSide::TransferIn: {
+            double added_cost = amount * price + fee;
+            if(method_ == CostMethod::Average && !book.lots.empty()) {
+                Lot& pool = book.lots.front();
+                pool.unit_cost = (pool.amount * pool.unit_cost + added_cost) / (pool.amount + amount);
+                pool.amount += amount;
+            } else {
+                book.lots.push_back({amount, added_cost / amount});
+            }
+            held += amount;
+            cost += added_cost;
+            break;
+        }
+        case TradeSide::Sell:
+        case TradeSide::TransferOut: {
+            if(amount > held * (1.0 + AMOUNT_EPSILON)) return false;
+            amount = std::min(amount, held);
+
+            double removed_cost = take_lots(book, amount);
+            if(side == TradeSide::Sell) {
+                realized += amount * price - fee - removed_cost;
+            } else {
+                realized -= fee;
+            }
+            held -= amount;
+            cost -= removed_cost;
+            // Closing the position exactly should not leave residue behind.
+            if(book.lots.empty() || held <= 0.0) {
+                book.lots.clear();
+                held = 0.0;
+                cost = 0.0;
+            }
+            break;
+        }
+    }
+
+    book.held.push_back(held);
+    book.cost.push_back(cost);
+    book.realized.push_back(realized);
+    book.fees.push_back(fees);
+    return true;
+}
+
+void Ledger::set_method(CostMethod method) {
+    if(method == method_) return;
+    method_ = method;
+
+    // Replay every coin's trades under the new matching rule. None can fail: the amounts held are the same.
+    for(auto& [coin_id, book] : books_) {
+        book.held.clear();
+        book.cost.clear();
+        book.realized.clear();
+        book.fees.clear();
+        book.lots.clear();
+        const Columns& t = book.trades;
+        for(std::size_t i = 0; i < t.time.size(); i++) {
+            apply(book, t.side[i], t.amount[i], t.price[i], t.fee[i]);
+        }
+    }
+}
+
+std::vector<std::string> Ledger::coins() const {
+    std::vector<std::string> result;
+    result.reserve(books_.size());
+    for(auto const& [coin_id, book] : books_) {
+        result.push_back(coin_id);
+    }
+    return result;
+}
+
+const Ledger::Columns* Ledger::columns(const std::string& coin_id) const {
+    auto it = books_.find(coin_id);
+    return it != books_.end() ? &it->second.trades : nullptr;
+}
+
+PositionState Ledger::position(const std::string& coin_id, double at) const {
+    auto it = books_.find(coin_id);
+    if(it == books_.end()) return {};
+    const Book& book = it->second;
+
+    auto end = std::upper_bound(book.trades.time.begin(), book.trades.time.end(), at);
+    std::size_t count = end - book.trades.time.begin();
+    if(count == 0) return {};
+
+    std::size_t i = count - 1;
+    return {book.held[i], book.cost[i], book.realized[i], book.fees[i], count};
+}
+
+std::size_t Ledger::erase(const std::string& coin_id) {
+    auto it = books_.find(coin_id);
+    if(it == books_.end()) return 0;
+    std::size_t removed = it->second.trades.time.size();
+    count_ -= removed;
+    books_.erase(it);
+    return removed;
+}
+
+void Ledger::clear() {
+    books_.clear();
+    count_ = 0;
+}
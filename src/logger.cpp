@@ -0,0 +1,144 @@
+#include "logger.hpp"
+#include <bit>
+#include <cstdio>
+#include <filesystem>
+
+const char* log_level_name(LogLevel level) {
+    switch(level) {
+        case LogLevel::Trace: return "TRACE";
+        case LogLevel::Debug: return "DEBUG";
+        case LogLevel::Info:  return "INFO";
+        case LogLevel::Warn:  return "WARN";
+        case LogLevel::Error: return "ERROR";
+        case LogLevel::Off:   return "OFF";
+    }
+    return "INFO";
+}
+
+Logger& app_logger() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger(std::size_t capacity) {
+    capacity = std::bit_ceil(std::max<std::size_t>(capacity, 2));
+    slots_ = std::make_unique<Slot[]>(capacity);
+    mask_ = capacity - 1;
+    // Each slot's sequence says which ticket may write it next (see claim).
+    for(std::size_t i = 0; i < capacity; i++) {
+        slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+Logger::~Logger() {
+    stop();
+}
+
+Logger::Slot* Logger::claim(std::size_t& pos) {
+    // Bounded MPSC ring (Vyukov): a slot is free for ticket `pos` once its sequence equals `pos`.
+    pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while(true) {
+        Slot& slot = slots_[pos & mask_];
+        std::size_t seq = slot.sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+        if(diff == 0) {
+            if(enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) return &slot;
+        } else if(diff < 0) {
+            return nullptr; // The writer has not consumed this slot yet: the ring is full.
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool Logger::drain_one() {
+    Slot& slot = slots_[dequeue_pos_ & mask_];
+    if(slot.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1) return false;
+
+    write_line(slot);
+    // Hand the slot back to producers for the ticket one lap ahead.
+    slot.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+    ++dequeue_pos_;
+    written_.store(dequeue_pos_, std::memory_order_release);
+    return true;
+}
+
+void Logger::write_line(const Slot& slot) {
+    auto seconds = std::chrono::floor<std::chrono::milliseconds>(slot.time);
+    char header[64];
+    auto header_end = std::format_to_n(header, sizeof(header), "{:%F %T} {:<5} ", seconds, log_level_name(slot.level));
+    int header_length = static_cast<int>(std::min<std::size_t>(header_end.size, sizeof(header)));
+
+    if(file_) {
+        if(file_bytes_ >= options_.max_bytes) rotate();
+        if(file_) {
+            std::fprintf(file_, "%.*s%.*s\n", header_length, header, static_cast<int>(slot.length), slot.text);
+            file_bytes_ += header_length + slot.length + 1;
+        }
+    }
+    // Only problems reach the console; a terminal write per debug line would stall the writer behind it.
+    if(options_.echo_to_console && slot.level >= LogLevel::Warn) {
+        std::fprintf(stderr, "%.*s\n", static_cast<int>(slot.length), slot.text);
+    }
+}
+
+void Logger::rotate() {
+    std::fclose(file_);
+    file_ = nullptr;
+
+    // tracker.log.1 -> tracker.log.2, ..., tracker.log -> tracker.log.1; the oldest is overwritten.
+    std::error_code ec;
+    for(int i = options_.max_files - 1; i > 0; i--) {
+        std::string from = i == 1 ? options_.path : std::format("{}.{}", options_.path, i - 1);
+        std::filesystem::rename(from, std::format("{}.{}", options_.path, i), ec);
+    }
+    if(options_.max_files <= 1) {
+        std::filesystem::remove(options_.path, ec);
+    }
+
+    file_ = std::fopen(options_.path.c_str(), "w");
+    file_bytes_ = 0;
+}
+
+void Logger::run(std::stop_token stop) {
+    while(!stop.stop_requested()) {
+        bool wrote = false;
+        while(drain_one()) wrote = true;
+        if(wrote && file_) std::fflush(file_);
+        if(!wrote) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    // Write out whatever was queued before shutdown.
+    while(drain_one()) {}
+    if(file_) std::fflush(file_);
+}
+
+void Logger::start(LoggerOptions options) {
+    if(writer_.joinable()) return;
+
+    options_ = std::move(options);
+    file_ = std::fopen(options_.path.c_str(), "a");
+    if(file_) {
+        std::error_code ec;
+        auto size = std::filesystem::file_size(options_.path, ec);
+        file_bytes_ = ec ? 0 : static_cast<std::size_t>(size);
+    }
+    writer_ = std::jthread([this](std::stop_token stop) { run(stop); });
+}
+
+void Logger::stop() {
+    if(!writer_.joinable()) return;
+    writer_.request_stop();
+    writer_.join();
+    if(file_) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+void Logger::flush() {
+    if(!writer_.joinable()) return;
+    std::size_t target = enqueue_pos_.load(std::memory_order_acquire);
+    while(written_.load(std::memory_order_acquire) < target) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
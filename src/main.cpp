@@ -3,6 +3,15 @@
 #include "analysis.hpp"
 #include "style.hpp"
 #include "custom_plots.hpp"
+#include "coin_cache.hpp"
+#include "frame_arena.hpp"
+#include "alloc_counter.hpp"
+#include "alerts.hpp"
+#include "logger.hpp"
+#include "ledger.hpp"
+#include "price_provider.hpp"
+#include "refresh_scheduler.hpp"
+#include "price_board.hpp"
 #include <imgui.h>
 #include <imgui-SFML.h>
 #include <implot.h>
@@ -15,12 +24,62 @@
 #include <iostream>
 #include <format>
 #include <map>
+#include <set>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <deque>
+#include <cmath>
 
 using namespace std::chrono_literals;
 
+/// @brief A currency the UI can display values in. Prices are always fetched in USD and converted locally.
+struct QuoteCurrency {
+    const char* api_id; // CoinGecko vs_currency code.
+    const char* label;
+    int decimals;
+};
+
+const QuoteCurrency QUOTE_CURRENCIES[] = {
+    {"usd", "USD", 2},
+    {"eur", "EUR", 2},
+    {"ils", "ILS", 2},
+    {"btc", "BTC", 8},
+};
+
+const char* ALERT_KIND_LABELS[] = {"Price above", "Price below", "% move", "SMA cross up", "SMA cross down"};
+const char* TRADE_SIDE_LABELS[] = {"Buy", "Sell", "Transfer In", "Transfer Out"};
+const char* COST_METHOD_LABELS[] = {"FIFO", "LIFO", "Average"};
+
+static double now_seconds() {
+    return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Short description of a rule for the alert list in the coin view.
+static std::string describe_alert(const AlertRule& rule) {
+    switch(rule.kind) {
+        case AlertKind::PriceAbove:   return std::format("Above {:.2f} USD", rule.threshold);
+        case AlertKind::PriceBelow:   return std::format("Below {:.2f} USD", rule.threshold);
+        case AlertKind::PercentMove:  return std::format("Move {:.2f}% in {} min", rule.threshold, rule.window_seconds / 60);
+        case AlertKind::SmaCrossUp:   return std::format("SMA-{} crosses above SMA-{}", rule.short_period, rule.long_period);
+        case AlertKind::SmaCrossDown: return std::format("SMA-{} crosses below SMA-{}", rule.short_period, rule.long_period);
+    }
+    return {};
+}
+
+// ImPlot axis formatter that converts USD tick values into the display currency.
+// The plotted data stays in USD, so switching currency never rebuilds any series.
+static int format_converted_tick(double value, char* buff, int size, void* user_data) {
+    double rate = *static_cast<const double*>(user_data);
+    return std::snprintf(buff, size, "%.6g", value * rate);
+}
+
 int main() {
 
     // --- Initialization ---
+    // Network workers log through the async logger; its writer thread is flushed and joined at exit.
+    app_logger().start();
+
     // Create the main application window with a specific size and title.
     sf::RenderWindow window(sf::VideoMode(1000, 700), "Crypto Tracker");
     // Prevent excessive CPU usage when the app is idle.
@@ -36,13 +95,91 @@ int main() {
 
     // --- Application State & Data ---
     MarketClient client;
-    CoinData current_data;
+    // Workers publish complete CoinData snapshots here; the UI reads one consistent version per frame.
+    SnapshotSlot<CoinData> coin_snapshot;
+    // Recently viewed and prefetched coins, so switching between them is instant.
+    CoinCache coin_cache;
+
+    // Alert rules are evaluated on the network workers as prices arrive; the UI only drains what fired.
+    AlertEngine alerts;
+    for(auto const& rule : load_alerts()) {
+        alerts.add_rule(rule, true);
+    }
+    std::deque<std::string> alertLog;
+    std::vector<AlertRule> coinAlerts;
+    std::vector<std::string> coinAlertLabels;
+    std::string coinAlertsFor;
+    bool coinAlertsDirty = true;
+    int newAlertKind = 0;
+    double newAlertThreshold = 0.0;
+    int newAlertWindowMinutes = 60;
+
+    // Price refreshes go to the healthiest provider and are hedged to the next one when it is slow.
+    // Set TRACKER_MIRROR_URL to a mirror of the CoinGecko API to give the hedge somewhere to go.
+    std::vector<std::shared_ptr<PriceProvider>> providers{std::make_shared<CoinGeckoProvider>()};
+    if(const char* mirror = std::getenv("TRACKER_MIRROR_URL")) {
+        providers.push_back(std::make_shared<CoinGeckoProvider>(mirror, "mirror"));
+    }
+    HedgedPriceSource price_source(std::move(providers));
+    std::vector<ProviderHealth> providerHealth;
+
+    // Launch network jobs that feed every observed price into the alert engine from the worker thread.
+    auto fetch_batch = [&price_source, &alerts](std::vector<std::string> ids, std::vector<std::string> currencies) {
+        return std::async(std::launch::async, [&price_source, &alerts, ids = std::move(ids), currencies = std::move(currencies)]() {
+            PriceBatch batch = price_source.fetch_prices(ids, currencies);
+            alerts.on_prices(batch.prices, now_seconds());
+            return batch;
+        });
+    };
+    // A coin we already hold only downloads the history points newer than its cached copy.
+    auto fetch_coin = [&client, &alerts, &coin_cache](std::string coin_id) {
+        auto previous = coin_cache.get(coin_id);
+        return std::async(std::launch::async, [&client, &alerts, coin_id = std::move(coin_id), previous = std::move(previous)]() {
+            auto data = previous ? client.refresh_coin_data(*previous) : client.get_coin_data(coin_id);
+            if(data) {
+                alerts.on_price(coin_id, data->current_price, now_seconds());
+            }
+            return data;
+        });
+    };
+    // The coin on screen after a scheduled batch: its price just arrived there, so only the history delta is fetched.
+    auto fetch_history = [&client, &coin_cache](std::string coin_id, double price) {
+        auto previous = coin_cache.get(coin_id);
+        return std::async(std::launch::async, [&client, coin_id = std::move(coin_id), previous = std::move(previous), price]() {
+            return previous ? client.refresh_coin_data(*previous, price) : client.get_coin_data(coin_id);
+        });
+    };
+    auto fetch_markets = [&client, &alerts](std::vector<std::string> ids) {
+        return std::async(std::launch::async, [&client, &alerts, ids = std::move(ids)]() {
+            auto markets = client.get_markets(ids);
+            double now = now_seconds();
+            for(auto const& summary : markets) {
+                alerts.on_price(summary.id, summary.current_price, now);
+            }
+            return markets;
+        });
+    };
     std::string status = "Ready";
+    status.reserve(128); // Status messages are reassigned in place, so keep them within one allocation.
     sf::Clock delta_clock;
 
     std::vector<CoinDef> coins = load_coins();
     std::map<std::string, PortfolioEntry> portfolio = load_portfolio();
 
+    // Coins with recorded trades take their holdings from the ledger; the rest keep the hand-edited entry.
+    Ledger ledger = load_ledger();
+    auto sync_from_ledger = [&ledger, &portfolio](const std::string& coin_id) {
+        PositionState position = ledger.position(coin_id);
+        portfolio[coin_id] = {position.amount, position.average_cost()};
+    };
+    for(auto const& coin_id : ledger.coins()) {
+        sync_from_ledger(coin_id);
+    }
+    int tradeSide = 0;
+    double tradeAmount = 0.0;
+    double tradePrice = 0.0;
+    double tradeFee = 0.0;
+
     int selected_index = -1;
     PortfolioEntry temp_entry;
     bool is_loading = true; // Tracks if a network request is in-flight to prevent duplicate requests.
@@ -51,12 +188,30 @@ int main() {
     // view state
     int chartMode = 0;
     bool waiting_for_ohlc = false;
+    std::string ohlc_coin_id; // Coin the in-flight OHLC request was made for.
 
     // analysis state
     bool showSmaShort = false;
     bool showSmaLong = false;
-    std::vector<double> smaShortData;
-    std::vector<double> smaLongData;
+    // The overlay set is fixed, so both SMAs are composed at compile time and computed in one pass.
+    FusedIndicators<SmaKernel<7>, SmaKernel<25>> overlays;
+
+    // Brings the overlays from the coin on screen to `fresh`. A refresh that only trimmed old points and
+    // appended new ones steps just the new points; anything else is recomputed.
+    auto update_overlays = [&overlays](const CoinData& shown, const CoinData& fresh) {
+        auto const& before = shown.history_time;
+        auto const& after = fresh.history_time;
+        if(shown.id == fresh.id && !before.empty() && !after.empty() && before.size() == shown.price_history.size()) {
+            auto kept_from = std::lower_bound(before.begin(), before.end(), after.front());
+            std::size_t dropped = kept_from - before.begin();
+            std::size_t kept = before.size() - dropped;
+            if(kept > 0 && kept <= after.size() && after[0] == *kept_from && after[kept - 1] == before.back()) {
+                overlays.extend(fresh.price_history, dropped);
+                return;
+            }
+        }
+        overlays.evaluate(fresh.price_history);
+    };
 
     //Temp editor variables
     double tempAmount = 0.0;
@@ -64,33 +219,191 @@ int main() {
 
     // Futures for managing non-blocking network calls.
     std::future<std::optional<CoinData>> futureCoin;
-    std::future<std::map<std::string, double>> futureBatch;
+    std::future<PriceBatch> futureBatch;
     std::future<std::vector<CoinDef>> futureSearch;
+    std::future<std::vector<MarketSummary>> futureMarkets;
+
+    // Watchlist grid: every coin's 7-day sparkline comes from the same paged markets request.
+    bool showWatchlist = false;
+    std::vector<MarketSummary> markets;
+    std::vector<std::string> marketTickers;
+    SparklineSet sparklines;
+    int const SPARKLINE_POINTS = 48; // Tiles are ~160px wide, so more points would not be visible.
+    sf::Clock marketsClock;
+    float const MARKETS_INTERVAL = 300.f; // The sparklines span 7 days, so a slow refresh keeps them current.
+
+    // Portfolio risk analytics, computed on a worker from the held coins' histories.
+    struct RiskResult {
+        std::vector<std::string> tickers;
+        RiskReport report;
+    };
+    std::future<RiskResult> futureRisk;
+    RiskReport risk;
+    std::vector<std::string> riskTickers;
+    std::vector<const char*> riskLabels;
     std::future<bool> futureOhlc;
+    std::future<std::optional<CoinData>> futurePrefetch;
+
+    // A coin selected while another coin fetch was still in flight; fetched as soon as that one lands.
+    std::string queued_coin_id;
+    sf::Clock prefetchClock;
+    float const PREFETCH_INTERVAL = 5.f; // Spacing between speculative fetches to stay under API rate limits.
 
     std::vector<const char*> pieLabels;
     std::vector<double> pieValue;
     double totalNetWorth = 0.0;
     double totalCostBasis = 0.0;
+    double totalRealized = 0.0;
+    std::map<std::string, double> latestPrices; // Last known USD price per coin from the batch refresh.
+
+    // Each coin refreshes on its own schedule: volatile, heavily held and on-screen coins most often,
+    // all within one request budget. Volatility comes from the coin's 24h history whenever it arrives.
+    RefreshScheduler scheduler;
+    for(auto const& coin : coins) {
+        scheduler.track(coin.api_id, now_seconds());
+    }
+    std::string visible_coin_id;
+    std::string pending_history_id; // Coin on screen whose chart is extended once the running batch lands.
+    auto show_coin = [&scheduler, &visible_coin_id](const std::string& coin_id) {
+        scheduler.set_visible(visible_coin_id, false);
+        scheduler.set_visible(coin_id, true);
+        visible_coin_id = coin_id;
+    };
+    auto note_history = [&scheduler](const CoinData& data) {
+        scheduler.set_volatility(data.id, calculate_volatility(data.price_history));
+    };
+    // Carries a newer quote into the coin on screen, so its headline price keeps up between chart refreshes.
+    auto publish_shown_price = [&](const std::map<std::string, double>& quotes) {
+        if(selected_index == -1) return;
+        auto shown = coin_snapshot.load();
+        auto quote = quotes.find(shown->id);
+        // A coin still waiting for its first load has no history to carry the price alongside.
+        if(shown->id != coins[selected_index].api_id || shown->current_price <= 0.0 || quote == quotes.end()) return;
+        if(quote->second <= 0.0 || quote->second == shown->current_price) return;
+
+        CoinData data = *shown;
+        data.current_price = quote->second;
+        auto fresh = std::make_shared<const CoinData>(std::move(data));
+        coin_cache.put(fresh);
+        coin_snapshot.publish(fresh);
+    };
+
+    // A PriceCollector on this host fetches for every dashboard and publishes to a shared-memory board.
+    // While it is alive, the coins it covers are read from there and the scheduler leaves them alone.
+    std::unique_ptr<PriceBoardReader> board = PriceBoardReader::attach();
+    std::uint64_t boardPublishes = 0;
+    std::optional<PortfolioValuation> boardValuation;
+    std::vector<double> boardTimes;
+    std::vector<double> boardPrices;
+    sf::Clock boardAttachClock;
+    float const BOARD_RETRY_INTERVAL = 30.f;
+    double const BOARD_STALE_SECONDS = 30.0;
+
+    // Recomputes the overview totals and pie chart from the latest known prices.
+    auto revalue_portfolio = [&]() {
+        pieLabels.clear();
+        pieValue.clear();
+        totalNetWorth = 0.0;
+        totalCostBasis = 0.0;
+        totalRealized = 0.0;
+        for(auto const& coin_id : ledger.coins()) {
+            totalRealized += ledger.position(coin_id).realized_pnl;
+        }
+        for(int i=0; i<coins.size(); i++) {
+            PortfolioEntry& entry = portfolio[coins[i].api_id];
+            // Filter out dust amounts to keep the pie chart clean.
+            if(entry.amount > 0.00001) {
+                auto quote = latestPrices.find(coins[i].api_id);
+                double currentVal = entry.amount * (quote != latestPrices.end() ? quote->second : 0.0);
+                double costVal = entry.amount * entry.buyPrice;
+
+                if(currentVal > 0.00001) {
+                    pieLabels.push_back(coins[i].ticker.c_str());
+                    pieValue.push_back(currentVal);
+                    totalNetWorth += currentVal;
+                    totalCostBasis += costVal;
+                }
+            }
+        }
+        for(auto const& coin : coins) {
+            auto quote = latestPrices.find(coin.api_id);
+            double value = portfolio[coin.api_id].amount * (quote != latestPrices.end() ? quote->second : 0.0);
+            scheduler.set_weight(coin.api_id, totalNetWorth > 0.0 ? value / totalNetWorth : 0.0);
+        }
+    };
+
+    // Every quote currency arrives with the batch price request; the derived cross rates make switching instant.
+    std::vector<std::string> quoteIds;
+    for(auto const& currency : QUOTE_CURRENCIES) {
+        quoteIds.push_back(currency.api_id);
+    }
+    FxMatrix fx(MarketClient::BASE_CURRENCY);
+    int display_currency = 0;
+
+    // Captures what is needed to render the dashboard instantly on the next launch.
+    auto make_snapshot = [&]() {
+        AppSnapshot snapshot;
+        snapshot.saved_at = now_seconds();
+        snapshot.prices = latestPrices;
+        for(int c = 0; c < static_cast<int>(fx.currencies().size()); c++) {
+            snapshot.fx_rates[fx.currencies()[c]] = fx.rate(0, c);
+        }
+        snapshot.coins = coin_cache.entries();
+        return snapshot;
+    };
+    std::future<void> futureSave;
+
+    // Warm start: render the last known state on the first frame, marked stale until the first refresh lands.
+    bool prices_stale = false;
+    std::string stale_label;
+    std::set<std::string> staleCoins; // Coins still showing the snapshot's copy; cleared as each is refetched.
+    if(auto warm = load_snapshot()) {
+        latestPrices = std::move(warm->prices);
+        fx = FxMatrix::from_quotes({{"snapshot", warm->fx_rates}}, MarketClient::BASE_CURRENCY);
+        // Insert oldest first so the most recently used coin ends up at the front of the LRU.
+        for(auto it = warm->coins.rbegin(); it != warm->coins.rend(); ++it) {
+            coin_cache.put(*it);
+            note_history(**it);
+            staleCoins.insert((*it)->id);
+        }
+        revalue_portfolio();
+        prices_stale = true;
+        int age_minutes = static_cast<int>((now_seconds() - warm->saved_at) / 60.0);
+        stale_label = std::format("STALE - last synced {} min ago", std::max(age_minutes, 0));
+        status = "Showing last session; refreshing...";
+    }
+
+    // Per-frame scratch space for transient UI strings, plus labels cached until the watchlist or holdings change.
+    FrameArena frame_arena;
+    std::vector<std::string> coinLabels;
+    bool coinLabelsDirty = true;
 
-    sf::Clock refreshClock;
-    float const REFRESH_INTERVAL = 60.f;
+    // Debug overlay (F1) showing heap allocations the UI thread made in the previous frame.
+    bool showDebugOverlay = false;
+    std::uint64_t frameAllocStart = heap_allocation_count();
+    std::uint64_t lastFrameAllocs = 0;
 
-    // Initial data fetch for the portfolio overview.
+    // Initial data fetch for the portfolio overview; every coin starts out due.
     std::vector<std::string> allIds;
     for(auto const& coin : coins) {
         allIds.push_back(coin.api_id);
     }
-    futureBatch = std::async(std::launch::async, &MarketClient::get_multi_price, &client, allIds);
+    futureBatch = fetch_batch(scheduler.take_due(now_seconds()), quoteIds);
 
     char search_buffer[128] = "";
     std::vector<CoinDef> search_results;
+    std::vector<std::string> search_labels;
     bool is_searching = false;
 
     bool openSearchPopup = false; // Use a flag to safely open popups outside of the main ImGui Begin/End block.
 
     // --- Main Application Loop ---
     while(window.isOpen()) {
+        // Frames are measured top to bottom of the loop, so one that ends early still counts.
+        std::uint64_t frameAllocEnd = heap_allocation_count();
+        lastFrameAllocs = frameAllocEnd - frameAllocStart;
+        frameAllocStart = frameAllocEnd;
+
         // --- Event Handling  ---
         // Process all pending events, such as mouse clicks, key presses, or window close requests.
         sf::Event event;
@@ -105,76 +418,213 @@ int main() {
 
         // --- GUI Update & Drawing ---
         ImGui::SFML::Update(window, delta_clock.restart());
+        frame_arena.reset();
+
+        // Drop the board of a collector that stopped, and look for a (re)started one now and then.
+        if(board && now_seconds() - board->heartbeat() >= BOARD_STALE_SECONDS) {
+            board.reset();
+            boardValuation.reset();
+        }
+        if(!board && boardAttachClock.getElapsedTime().asSeconds() >= BOARD_RETRY_INTERVAL) {
+            board = PriceBoardReader::attach();
+            boardPublishes = 0;
+            boardAttachClock.restart();
+        }
+        if(board && board->publishes() != boardPublishes) {
+            boardPublishes = board->publishes();
+            double now = now_seconds();
+            std::map<std::string, double> boardQuotes;
+            for(auto const& coin : coins) {
+                if(auto quote = board->quote(coin.api_id)) {
+                    boardQuotes[coin.api_id] = quote->price;
+                    latestPrices[coin.api_id] = quote->price;
+                }
+            }
+            auto rates = board->fx_rates();
+            if(rates.size() > 1) {
+                fx = FxMatrix::from_quotes({{"board", rates}}, MarketClient::BASE_CURRENCY);
+            }
+            if(!boardQuotes.empty()) {
+                std::vector<std::string> covered;
+                for(auto const& [id, price] : boardQuotes) {
+                    covered.push_back(id);
+                }
+                scheduler.mark_refreshed(covered, now, 0.0);
+                alerts.on_prices(boardQuotes, now);
+                revalue_portfolio();
+                prices_stale = false;
+            }
 
-        // Trigger a data refresh automatically if the interval has passed and no other request is active.
-        if(!is_loading && refreshClock.getElapsedTime().asSeconds() >= REFRESH_INTERVAL) {
-            is_loading = true;
-            status = "Auto-Refreshing...";
-            refreshClock.restart();
+            // Histories come from the board too, so the chart, overlays and volatility keep moving for the
+            // coins it covers. Cached coins are updated oldest first to keep their LRU order.
+            auto cached = coin_cache.entries();
+            for(auto it = cached.rbegin(); it != cached.rend(); ++it) {
+                const CoinData& before = **it;
+                if(!board->history(before.id, boardTimes, boardPrices)) continue;
+                if(!before.history_time.empty() && boardTimes.back() <= before.history_time.back()) continue;
+
+                CoinData data = before;
+                data.history_time = boardTimes;
+                data.price_history = boardPrices;
+                auto quote = boardQuotes.find(before.id);
+                if(quote != boardQuotes.end()) {
+                    data.current_price = quote->second;
+                }
+                auto fresh = std::make_shared<const CoinData>(std::move(data));
+                coin_cache.put(fresh);
+                note_history(*fresh);
+                staleCoins.erase(fresh->id);
+                if(selected_index != -1 && coins[selected_index].api_id == fresh->id) {
+                    update_overlays(*coin_snapshot.load(), *fresh);
+                    coin_snapshot.publish(fresh);
+                }
+            }
+            // The board's quotes move far more often than its histories, so the coin on screen takes them directly.
+            publish_shown_price(boardQuotes);
+            boardValuation = board->valuation();
+        }
 
-            if(selected_index == -1) {
-                allIds.clear();
-                for(auto const& coin : coins)
-                    allIds.push_back(coin.api_id);
+        // The watchlist's sparklines go ahead of the batch on their own slow clock, so the batch never starves them.
+        if(selected_index == -1 && showWatchlist && !futureMarkets.valid() && marketsClock.getElapsedTime().asSeconds() >= MARKETS_INTERVAL
+            && scheduler.try_spend(now_seconds(), 1.0)) {
+            futureMarkets = fetch_markets(allIds);
+            marketsClock.restart();
+        }
 
-                futureBatch = std::async(std::launch::async, &MarketClient::get_multi_price, &client, allIds);
-            } else {
-                futureCoin = std::async(std::launch::async, &MarketClient::get_coin_data, &client, coins[selected_index].api_id);
+        // Refresh whichever coins the scheduler has due, all in one batch, while no other request is active.
+        if(!is_loading && !futureBatch.valid()) {
+            double now = now_seconds();
+            std::vector<std::string> due = scheduler.take_due(now);
+            if(!due.empty()) {
+                is_loading = true;
+                status = "Auto-Refreshing...";
+
+                // The coin on screen also gets its chart extended once the batch lands, from the request the
+                // scheduler holds back for it.
+                bool selected_due = selected_index != -1 && std::find(due.begin(), due.end(), coins[selected_index].api_id) != due.end();
+                pending_history_id = selected_due ? coins[selected_index].api_id : std::string();
+                futureBatch = fetch_batch(std::move(due), quoteIds);
             }
         }
 
         // Check if the batch price fetch is complete without blocking the main thread.
         if(futureBatch.valid() && futureBatch.wait_for(0s) == std::future_status::ready) {    
-            auto price = futureBatch.get();
-            pieLabels.clear();
-            pieValue.clear();
-            totalNetWorth = 0.0;
-            totalCostBasis = 0.0;
-            for(int i=0; i<coins.size(); i++) {
-                PortfolioEntry& entry = portfolio[coins[i].api_id];
-                // Filter out dust amounts to keep the pie chart clean.
-                if(entry.amount > 0.00001) {
-
-                    double currentVal = entry.amount * price[coins[i].api_id];
-                    double costVal = entry.amount * entry.buyPrice;
-
-                    if(currentVal > 0.00001) {
-                        pieLabels.push_back(coins[i].ticker.c_str());
-                        pieValue.push_back(currentVal);
-                        totalNetWorth += currentVal;
-                        totalCostBasis += costVal;
-                    }
-                }
+            auto batch = futureBatch.get();
+            auto& price = batch.prices;
+            for(auto const& [id, value] : price) {
+                latestPrices[id] = value;
+            }
+            // Keep the last good rates if this response carried none.
+            if(batch.fx.currencies().size() > 1) {
+                fx = std::move(batch.fx);
             }
+            revalue_portfolio();
+            publish_shown_price(price);
+            if(!price.empty()) {
+                prices_stale = false;
+            }
+            providerHealth = price_source.health();
             status = "Portfolio Synced.";
             is_loading = false; 
-            refreshClock.restart(); 
+
+            if(!pending_history_id.empty()) {
+                auto fresh_price = price.find(pending_history_id);
+                bool still_shown = selected_index != -1 && coins[selected_index].api_id == pending_history_id;
+                if(still_shown && fresh_price != price.end() && !futureCoin.valid() && scheduler.try_spend(now_seconds(), 1.0)) {
+                    is_loading = true;
+                    futureCoin = fetch_history(pending_history_id, fresh_price->second);
+                }
+                pending_history_id.clear();
+            }
+
+            // Refresh the warm-start snapshot in the background, skipping if the previous save is still writing.
+            if(!futureSave.valid() || futureSave.wait_for(0s) == std::future_status::ready) {
+                futureSave = std::async(std::launch::async, [snapshot = make_snapshot()] { save_snapshot(snapshot); });
+            }
         } 
 
         // Check if the single coin data fetch is complete.
         if(futureCoin.valid() && futureCoin.wait_for(0s) == std::future_status::ready) {
+            std::string fetched_id;
             try {
                 auto result = futureCoin.get();
                 if(result.has_value()) {
-                    current_data = result.value();
-
-                    if(!current_data.price_history.empty()) {
-                        smaShortData = calculate_sma(current_data.price_history, 7);
-                        smaLongData = calculate_sma(current_data.price_history, 25);
+                    fetched_id = result->id;
+                    // Move the fetched data into a snapshot instead of deep-copying it on the UI thread.
+                    auto fresh = std::make_shared<const CoinData>(std::move(*result));
+                    coin_cache.put(fresh);
+                    note_history(*fresh);
+                    staleCoins.erase(fresh->id);
+
+                    // The user may have moved on to another coin while this one was loading.
+                    if(selected_index != -1 && coins[selected_index].api_id == fresh->id) {
+                        update_overlays(*coin_snapshot.load(), *fresh);
+                        coin_snapshot.publish(fresh);
+                        status.assign("Updated: ").append(coins[selected_index].name);
                     }
-
-                    status = "Updated: " + coins[selected_index].name;
                 }
             } catch (...) {
                 status = "Error";
             }
             is_loading = false; 
-            refreshClock.restart(); 
+
+            if(!queued_coin_id.empty() && queued_coin_id != fetched_id) {
+                is_loading = true;
+                futureCoin = fetch_coin(queued_coin_id);
+            }
+            queued_coin_id.clear();
+        }
+
+        // Speculative fetches only warm the cache, unless the user already clicked the coin being prefetched.
+        if(futurePrefetch.valid() && futurePrefetch.wait_for(0s) == std::future_status::ready) {
+            auto result = futurePrefetch.get();
+            if(result.has_value()) {
+                auto fresh = std::make_shared<const CoinData>(std::move(*result));
+                coin_cache.put(fresh);
+                note_history(*fresh);
+                staleCoins.erase(fresh->id);
+
+                if(selected_index != -1 && coins[selected_index].api_id == fresh->id && coin_snapshot.load()->current_price <= 0.0) {
+                    overlays.evaluate(fresh->price_history);
+                    coin_snapshot.publish(fresh);
+                }
+            }
+            prefetchClock.restart();
+        }
+
+        // While idle, prefetch the coins the user is most likely to open next: sidebar neighbours first, then holdings.
+        if(!is_loading && !futurePrefetch.valid() && prefetchClock.getElapsedTime().asSeconds() >= PREFETCH_INTERVAL) {
+            std::string candidate;
+            auto consider = [&](int index) {
+                if(candidate.empty() && index >= 0 && index < static_cast<int>(coins.size()) && !coin_cache.contains(coins[index].api_id)) {
+                    candidate = coins[index].api_id;
+                }
+            };
+            consider(selected_index + 1);
+            consider(selected_index - 1);
+            for(int i=0; i<coins.size(); i++) {
+                auto held = portfolio.find(coins[i].api_id);
+                if(held != portfolio.end() && held->second.amount > 0.00001) {
+                    consider(i);
+                }
+            }
+
+            if(!candidate.empty()) {
+                futurePrefetch = fetch_coin(candidate);
+            }
+            prefetchClock.restart();
         }
 
         if(waiting_for_ohlc && futureOhlc.valid() && futureOhlc.wait_for(0s) == std::future_status::ready) {
             bool success = futureOhlc.get();
+            waiting_for_ohlc = false;
             if(success) {
+                // Keep the candles with the cached copy so they survive switching away and back. The user may
+                // have switched coins since, and a coin still waiting for its data must not be cached.
+                auto loaded = coin_snapshot.load();
+                if(loaded->id == ohlc_coin_id && loaded->current_price > 0.0) {
+                    coin_cache.put(loaded);
+                }
                 status = "OHLC Loaded.";
                 should_reset_axes = true;
             } else {
@@ -182,12 +632,83 @@ int main() {
             }
         }
 
+        if(futureMarkets.valid() && futureMarkets.wait_for(0s) == std::future_status::ready) {
+            auto fresh = futureMarkets.get();
+            if(!fresh.empty()) {
+                markets = std::move(fresh);
+                marketTickers.clear();
+                std::vector<std::vector<double>> series;
+                series.reserve(markets.size());
+                for(auto& summary : markets) {
+                    auto coin = std::find_if(coins.begin(), coins.end(), [&](auto const& c) { return c.api_id == summary.id; });
+                    marketTickers.push_back(coin != coins.end() ? coin->ticker : summary.id);
+                    // A null price in the markets response parses as 0; keep the last real one.
+                    if(summary.current_price > 0.0) latestPrices[summary.id] = summary.current_price;
+                    series.push_back(std::move(summary.sparkline));
+                }
+                // The raw series are only needed to build the shared buffer.
+                sparklines.build(series, SPARKLINE_POINTS);
+                revalue_portfolio();
+                status = "Watchlist Synced.";
+            } else {
+                status = "Watchlist Failed (Rate Limit?)";
+            }
+        }
+
+        if(futureRisk.valid() && futureRisk.wait_for(0s) == std::future_status::ready) {
+            auto result = futureRisk.get();
+            risk = std::move(result.report);
+            riskTickers = std::move(result.tickers);
+            riskLabels.clear();
+            for(auto const& ticker : riskTickers) {
+                riskLabels.push_back(ticker.c_str());
+            }
+            status = risk.assets > 0 ? "Risk analysis ready." : "Risk analysis needs price history.";
+        }
+
         // Check if the coin search is complete.
         if(futureSearch.valid() && futureSearch.wait_for(0s) == std::future_status::ready) {
             search_results = futureSearch.get();
+            search_labels.clear();
+            for(auto const& res : search_results) {
+                search_labels.push_back(std::format("{} ({})", res.name, res.ticker));
+            }
             is_searching = false;
         }
 
+        // Sidebar labels only change with the watchlist or holdings, so build them once rather than every frame.
+        if(coinLabelsDirty) {
+            coinLabels.clear();
+            for(auto const& coin : coins) {
+                auto held = portfolio.find(coin.api_id);
+                double amount = held != portfolio.end() ? held->second.amount : 0.0;
+                coinLabels.push_back(amount > 0.00001 ? std::format("{} ({:.2f})", coin.ticker, amount) : coin.ticker);
+            }
+            coinLabelsDirty = false;
+        }
+
+        for(auto& fired : alerts.drain_fired()) {
+            status.assign("ALERT: ").append(fired.message);
+            alertLog.push_front(std::move(fired.message));
+            if(alertLog.size() > 50) alertLog.pop_back();
+        }
+
+        // Resolve the display currency once per frame, falling back to USD until its rate is known.
+        int shown_currency = display_currency;
+        double display_rate = fx.rate(MarketClient::BASE_CURRENCY, QUOTE_CURRENCIES[shown_currency].api_id);
+        if(display_rate <= 0.0) {
+            shown_currency = 0;
+            display_rate = 1.0;
+        }
+        // Formats a USD amount in the display currency into this frame's arena.
+        auto format_money = [&](double usd_amount) {
+            QuoteCurrency const& currency = QUOTE_CURRENCIES[shown_currency];
+            return frame_arena.format("{:.{}f} {}", usd_amount * display_rate, currency.decimals, currency.label);
+        };
+
+        // Pin the latest published coin data for the rest of this frame.
+        std::shared_ptr<const CoinData> current_data = coin_snapshot.load();
+
         // --- DASHBOARD LAYOUT ---
         ImGui::SetNextWindowPos(ImVec2(0, 0));
         // Force the main dashboard window to fill the entire application window.
@@ -207,14 +728,39 @@ int main() {
                 openSearchPopup = true;
             }
 
+            ImGui::SetNextItemWidth(-1);
+            if(ImGui::BeginCombo("##Currency", QUOTE_CURRENCIES[display_currency].label)) {
+                for(int q = 0; q < static_cast<int>(std::size(QUOTE_CURRENCIES)); q++) {
+                    if(ImGui::Selectable(QUOTE_CURRENCIES[q].label, display_currency == q)) {
+                        display_currency = q;
+                    }
+                }
+                ImGui::EndCombo();
+            }
+
             ImGui::Separator();
 
             // Use a selected index of -1 as a sentinel for the main portfolio overview.
-            if(ImGui::Selectable(" PORTFOLIO OVERVIEW", selected_index == -1)) {
+            if(ImGui::Selectable(" PORTFOLIO OVERVIEW", selected_index == -1 && !showWatchlist)) {
                 selected_index = -1;
+                showWatchlist = false;
+                show_coin({});
                 is_loading = true;
                 status = "Updating Total Balance...";
-                futureBatch = std::async(std::launch::async, &MarketClient::get_multi_price, &client, allIds);
+                scheduler.mark_refreshed(allIds, now_seconds(), 1.0);
+                futureBatch = fetch_batch(allIds, quoteIds);
+            }
+
+            if(ImGui::Selectable(" WATCHLIST", selected_index == -1 && showWatchlist)) {
+                selected_index = -1;
+                showWatchlist = true;
+                show_coin({});
+                if(!futureMarkets.valid()) {
+                    scheduler.mark_refreshed({}, now_seconds(), 1.0);
+                    status = "Updating Watchlist...";
+                    futureMarkets = fetch_markets(allIds);
+                    marketsClock.restart();
+                }
             }
 
             // --- Column 1: Coin Selection ---
@@ -224,19 +770,33 @@ int main() {
             ImGui::Separator();
 
             for(int i=0; i<coins.size(); i++) {
-                double amount = portfolio[coins[i].api_id].amount;
-                std::string label = amount > 0.00001 ? std::format("{} ({:.2f})", coins[i].ticker, amount) : coins[i].ticker;
-                
-                if(ImGui::Selectable(label.c_str(), selected_index == i)) {
-                    // Fetch data only if a new coin is selected and no other request is active.
-                    if(selected_index != i && !is_loading) {
+                if(ImGui::Selectable(coinLabels[i].c_str(), selected_index == i)) {
+                    if(selected_index != i) {
                         selected_index = i;
+                        showWatchlist = false;
+                        show_coin(coins[i].api_id);
                         temp_entry = portfolio[coins[i].api_id];
-                        is_loading = true;
-                        status = "Fetching " + coins[i].name;
-                        current_data.price_history.clear();
-                        current_data.current_price = 0.0;
-                        futureCoin = std::async(std::launch::async, &MarketClient::get_coin_data, &client, coins[i].api_id);   
+
+                        // Show the cached copy immediately and refresh it behind the scenes.
+                        auto cached = coin_cache.get(coins[i].api_id);
+                        if(cached) {
+                            overlays.evaluate(cached->price_history);
+                            coin_snapshot.publish(cached);
+                            status.assign("Refreshing ").append(coins[i].name);
+                        } else {
+                            overlays.clear();
+                            coin_snapshot.publish(CoinData{coins[i].api_id});
+                            status.assign("Fetching ").append(coins[i].name);
+                        }
+
+                        // Never block on an in-flight fetch; queue this coin to be fetched right after it.
+                        scheduler.mark_refreshed({coins[i].api_id}, now_seconds(), 2.0);
+                        if(futureCoin.valid()) {
+                            queued_coin_id = coins[i].api_id;
+                        } else {
+                            is_loading = true;
+                            futureCoin = fetch_coin(coins[i].api_id);
+                        }
                     }
                 }
             }
@@ -245,21 +805,48 @@ int main() {
             ImGui::TableSetColumnIndex(1);
 
             // Status text on the left, refresh timer on the right
-            ImGui::TextDisabled(status.c_str());
+            ImGui::TextDisabled("%s", status.c_str());
 
-            float timeLeft = REFRESH_INTERVAL - refreshClock.getElapsedTime().asSeconds();
-            if(timeLeft < 0) {
-                timeLeft = 0;
-            }
+            double now = now_seconds();
+            double timeLeft = std::max(scheduler.next_due(now) - now, 0.0);
             ImGui::SameLine();
-            std::string refresh_text = std::format("Refresh: {:.0f}s", timeLeft);
-            ImGui::SetCursorPosX(ImGui::GetCursorPosX() + ImGui::GetContentRegionAvail().x - ImGui::CalcTextSize(refresh_text.c_str()).x);
-            ImGui::TextDisabled(refresh_text.c_str());
+            const char* refresh_text = std::isfinite(timeLeft) ? frame_arena.format("Refresh: {:.0f}s", timeLeft) : "Refresh: -";
+            ImGui::SetCursorPosX(ImGui::GetCursorPosX() + ImGui::GetContentRegionAvail().x - ImGui::CalcTextSize(refresh_text).x);
+            ImGui::TextDisabled("%s", refresh_text);
+
+            if(selected_index == -1 && showWatchlist) {
+                ImGui::TextColored(ImVec4(0, 1, 0, 1), "Watchlist (7d)");
+                if(futureMarkets.valid()) {
+                    ImGui::SameLine();
+                    ImGui::TextDisabled("Loading...");
+                }
+                ImGui::Separator();
+
+                float const TILE_WIDTH = 170.0f;
+                int columns = std::max(1, static_cast<int>(ImGui::GetContentRegionAvail().x / TILE_WIDTH));
+                if(!markets.empty() && ImGui::BeginTable("WatchlistGrid", columns, ImGuiTableFlags_SizingStretchSame | ImGuiTableFlags_BordersInnerV)) {
+                    for(int m = 0; m < static_cast<int>(markets.size()); m++) {
+                        ImGui::TableNextColumn();
+                        MarketSummary const& summary = markets[m];
+                        ImVec4 trendColor = (summary.change_24h >= 0) ? ImVec4(0, 1, 0, 1) : ImVec4(1, 0, 0, 1);
 
-            if(selected_index == -1) {
+                        ImGui::Text("%s", marketTickers[m].c_str());
+                        ImGui::SameLine();
+                        ImGui::TextColored(trendColor, "%+.2f%%", summary.change_24h);
+                        ImGui::TextDisabled("%s", format_money(summary.current_price));
+                        DrawSparkline(sparklines.line(m), sparklines.points_per_line, ImVec2(ImGui::GetContentRegionAvail().x, 40.0f), ImGui::GetColorU32(trendColor));
+                        ImGui::Spacing();
+                    }
+                    ImGui::EndTable();
+                }
+            } else if(selected_index == -1) {
                 ImGui::TextColored(ImVec4(0, 1, 0, 1), "Total Worth Net");
+                if(prices_stale) {
+                    ImGui::SameLine();
+                    ImGui::TextColored(ImVec4(1, 0.6f, 0, 1), "%s", stale_label.c_str());
+                }
                 ImGui::SetWindowFontScale(3.0f);
-                ImGui::Text("$%.2f", totalNetWorth);
+                ImGui::Text("%s", format_money(totalNetWorth));
                 ImGui::SetWindowFontScale(1.0f);
 
                 // calculate profit and loss
@@ -272,32 +859,119 @@ int main() {
                 ImGui::Text("Total PNL");
 
                 ImVec4 pnlColor = (totalPNL >= 0) ? ImVec4(0,1,0,1) : ImVec4(1,0,0,1);
-                ImGui::TextColored(pnlColor, "$%.2f (%.2f%%)", totalPNL);
+                ImGui::TextColored(pnlColor, "%s (%.2f%%)", format_money(totalPNL), totalPNLPercent);
+                if(!ledger.empty()) {
+                    ImGui::TextDisabled("Realized: %s", format_money(totalRealized));
+                }
+                if(boardValuation) {
+                    ImGui::TextDisabled("Collector: %s", format_money(boardValuation->net_worth));
+                }
                 ImGui::EndGroup();
 
                 ImGui::Separator();
+
+                if(!alertLog.empty() && ImGui::CollapsingHeader("Recent Alerts")) {
+                    for(auto const& entry : alertLog) {
+                        ImGui::BulletText("%s", entry.c_str());
+                    }
+                    ImGui::Separator();
+                }
         
                 if(!pieValue.empty()) {
-                    if(ImPlot::BeginPlot("##Pie", ImVec2(-1, -1), ImPlotFlags_Equal | ImPlotFlags_NoMouseText)) {
-                        ImPlot::SetupAxes(nullptr, nullptr, ImPlotAxisFlags_NoDecorations, ImPlotAxisFlags_NoDecorations);
-                        ImPlot::PlotPieChart(pieLabels.data(), pieValue.data(), static_cast<int>(pieValue.size()), 0.5, 0.5, 0.35, "%.1f", 90);
-                        ImPlot::EndPlot();
+                    if(futureRisk.valid()) {
+                        ImGui::TextDisabled("Computing risk...");
+                    } else if(ImGui::Button("Analyze Risk")) {
+                        // Snapshot the holdings on the UI thread; histories are gathered and crunched on the worker.
+                        struct Holding { std::string id; std::string ticker; double value; };
+                        std::vector<Holding> held;
+                        for(auto const& coin : coins) {
+                            auto entry = portfolio.find(coin.api_id);
+                            auto quote = latestPrices.find(coin.api_id);
+                            if(entry != portfolio.end() && quote != latestPrices.end() && entry->second.amount > 0.00001) {
+                                held.push_back({coin.api_id, coin.ticker, entry->second.amount * quote->second});
+                            }
+                        }
+                        status = "Analyzing portfolio risk...";
+                        futureRisk = std::async(std::launch::async, [&client, &coin_cache, held]() {
+                            RiskResult result;
+                            std::vector<std::vector<double>> returns;
+                            std::vector<double> weights;
+                            for(auto const& holding : held) {
+                                auto data = coin_cache.get(holding.id);
+                                if(!data || data->price_history.size() < 3) {
+                                    auto fetched = client.get_coin_data(holding.id);
+                                    if(!fetched) continue;
+                                    data = std::make_shared<const CoinData>(std::move(*fetched));
+                                    coin_cache.put(data);
+                                }
+                                auto series = calculate_returns(data->price_history);
+                                if(series.size() < 2) continue;
+                                returns.push_back(std::move(series));
+                                weights.push_back(holding.value);
+                                result.tickers.push_back(holding.ticker);
+                            }
+                            result.report = calculate_risk(returns, weights);
+                            return result;
+                        });
+                    }
+
+                    bool showRisk = risk.assets > 0;
+                    if(ImGui::BeginTable("OverviewCharts", showRisk ? 2 : 1)) {
+                        ImGui::TableNextColumn();
+                        if(ImPlot::BeginPlot("##Pie", ImVec2(-1, -1), ImPlotFlags_Equal | ImPlotFlags_NoMouseText)) {
+                            ImPlot::SetupAxes(nullptr, nullptr, ImPlotAxisFlags_NoDecorations, ImPlotAxisFlags_NoDecorations);
+                            ImPlot::PlotPieChart(pieLabels.data(), pieValue.data(), static_cast<int>(pieValue.size()), 0.5, 0.5, 0.35, "%.1f", 90);
+                            ImPlot::EndPlot();
+                        }
+
+                        if(showRisk) {
+                            ImGui::TableNextColumn();
+                            // Volatility and VaR are per sample of the 24h history (5-minute returns).
+                            ImGui::Text("Volatility: %.3f%%", risk.portfolio_volatility * 100.0);
+                            ImGui::Text("VaR 95%%: %.3f%% hist | %.3f%% param", risk.var_historical * 100.0, risk.var_parametric * 100.0);
+
+                            int n = static_cast<int>(risk.assets);
+                            ImPlot::PushColormap(ImPlotColormap_RdBu);
+                            if(ImPlot::BeginPlot("##Correlation", ImVec2(-1, -1), ImPlotFlags_NoLegend | ImPlotFlags_NoMouseText)) {
+                                ImPlot::SetupAxes(nullptr, nullptr, ImPlotAxisFlags_Lock, ImPlotAxisFlags_Lock);
+                                ImPlot::SetupAxisTicks(ImAxis_X1, 0 + 1.0 / (2 * n), 1 - 1.0 / (2 * n), n, riskLabels.data());
+                                ImPlot::SetupAxisTicks(ImAxis_Y1, 1 - 1.0 / (2 * n), 0 + 1.0 / (2 * n), n, riskLabels.data());
+                                // Cell labels become unreadable on large portfolios, so only print them for small ones.
+                                ImPlot::PlotHeatmap("##Corr", risk.correlation.data(), n, n, -1.0, 1.0, n <= 12 ? "%.2f" : nullptr, ImPlotPoint(0, 0), ImPlotPoint(1, 1));
+                                ImPlot::EndPlot();
+                            }
+                            ImPlot::PopColormap();
+                        }
+                        ImGui::EndTable();
                     }
                 }
             } else {
                 CoinDef& c = coins[selected_index];
                 ImGui::TextColored(ImVec4(1, 0.8f, 0, 1), "%s (%s)", coins[selected_index].name.c_str(), coins[selected_index].ticker.c_str());
                 ImGui::SameLine();
+                if(staleCoins.contains(c.api_id)) {
+                    ImGui::TextColored(ImVec4(1, 0.6f, 0, 1), "%s", stale_label.c_str());
+                    ImGui::SameLine();
+                }
                 
                 const char* delete_text = "Delete Coin";
                 float button_width = ImGui::CalcTextSize(delete_text).x + ImGui::GetStyle().FramePadding.x * 2.0f;
                 ImGui::SetCursorPosX(ImGui::GetCursorPosX() + ImGui::GetContentRegionAvail().x - button_width);
                 if(ImGui::Button(delete_text)) {
+                    coin_cache.erase(c.api_id);
+                    scheduler.untrack(c.api_id);
+                    // Otherwise the trades would rebuild the deleted holding on the next launch.
+                    if(ledger.erase(c.api_id) > 0) {
+                        save_ledger(ledger);
+                    }
+                    allIds.erase(std::remove(allIds.begin(), allIds.end(), c.api_id), allIds.end());
+                    visible_coin_id.clear();
                     portfolio.erase(c.api_id);
                     save_portfolio(portfolio);
 
                     coins.erase(coins.begin() + selected_index);
                     save_coins(coins);
+                    coinLabelsDirty = true;
 
                     selected_index = -1;
                 }
@@ -314,13 +988,14 @@ int main() {
                 
                 ImGui::Separator();
 
-                if(is_loading && futureCoin.valid()) {
+                // Only block the view when there is nothing cached to show for this coin yet.
+                if(current_data->current_price <= 0.0 && (futureCoin.valid() || !queued_coin_id.empty())) {
 
                     ImGui::Text("Loading Data");
                 } else {
-                    if(current_data.current_price > 0.0) {
+                    if(current_data->current_price > 0.0) {
                         ImGui::SetWindowFontScale(2.5f);
-                        ImGui::Text("$%.2f", current_data.current_price);
+                        ImGui::Text("%s", format_money(current_data->current_price));
                         ImGui::SetWindowFontScale(1.0f);
                     }
 
@@ -331,10 +1006,11 @@ int main() {
                     ImGui::SameLine();
                     if(ImGui::RadioButton("CanadelStick", chartMode == 1)) {
                         chartMode = 1;
-                        if(current_data.time.empty() && !waiting_for_ohlc) {
+                        if(current_data->time.empty() && !waiting_for_ohlc) {
                             waiting_for_ohlc = true;
                             status = "Fetching OHLC....";
-                            futureOhlc = client.fetch_ohlc_async(coins[selected_index].api_id, current_data);
+                            ohlc_coin_id = coins[selected_index].api_id;
+                            futureOhlc = client.fetch_ohlc_async(ohlc_coin_id, coin_snapshot);
                         }
                     }
 
@@ -344,26 +1020,29 @@ int main() {
                     }
 
                     if(ImPlot::BeginPlot("Analysis",ImVec2(-1, 350), ImPlotFlags_NoLegend)) {
+                        ImPlot::SetupAxisFormat(ImAxis_Y1, format_converted_tick, &display_rate);
                         if(chartMode == 1) {
-                            if(!current_data.time.empty()) {
+                            if(!current_data->time.empty()) {
                                 ImPlot::SetupAxis(ImAxis_X1, nullptr);
                                 ImPlot::SetupAxisScale(ImAxis_X1, ImPlotScale_Time);
                                 PlotCandlestick(
                                     "OHLC",
-                                    current_data.time.data(),
-                                    current_data.open.data(),
-                                    current_data.close.data(),
-                                    current_data.high.data(),
-                                    current_data.low.data(),
-                                    static_cast<int>(current_data.time.size())
+                                    current_data->time.data(),
+                                    current_data->open.data(),
+                                    current_data->close.data(),
+                                    current_data->high.data(),
+                                    current_data->low.data(),
+                                    static_cast<int>(current_data->time.size())
                                 );
                             } else {
                                 ImGui::Text("Loading Candles...");
                             }
                         } else {
-                            if(!current_data.price_history.empty()) {
-                                ImPlot::PlotLine("Price (USD)", current_data.price_history.data(), current_data.price_history.size());
-                                if(showSmaShort && !smaLongData.empty()){
+                            if(!current_data->price_history.empty()) {
+                                ImPlot::PlotLine("Price (USD)", current_data->price_history.data(), current_data->price_history.size());
+                                auto const& smaShortData = overlays.get<0>();
+                                auto const& smaLongData = overlays.get<1>();
+                                if(showSmaShort && !smaShortData.empty()){
                                     ImPlot::SetNextLineStyle(ImVec4(0, 1, 1, 1));
                                     ImPlot::PlotLine("SMA-7", smaShortData.data(), smaShortData.size());
                                 }
@@ -386,45 +1065,192 @@ int main() {
                     ImGui::Separator();
                     ImGui::TextDisabled("Portfolio");
 
-                    // Use temp_entry for editing, commit to portfolio on button press
+                    const Ledger::Columns* trades = ledger.columns(c.api_id);
+                    if(!trades) {
+                        // Use temp_entry for editing, commit to portfolio on button press
 
-                    ImGui::Text("Holdings:");
-                    ImGui::SameLine(100);
-                    ImGui::SetNextItemWidth(150);
+                        ImGui::Text("Holdings:");
+                        ImGui::SameLine(100);
+                        ImGui::SetNextItemWidth(150);
 
-                    if(ImGui::InputDouble("##Amount", &temp_entry.amount, 0.0, 0.0, "%.6f")) {
-                        if (temp_entry.buyPrice == 0.0 && current_data.current_price > 0.0) {
-                            temp_entry.buyPrice = current_data.current_price;
+                        if(ImGui::InputDouble("##Amount", &temp_entry.amount, 0.0, 0.0, "%.6f")) {
+                            if (temp_entry.buyPrice == 0.0 && current_data->current_price > 0.0) {
+                                temp_entry.buyPrice = current_data->current_price;
+                            }
                         }
-                    }
 
-                    ImGui::Text("Avg Buy Price:");
-                    ImGui::SameLine(135);
-                    ImGui::SetNextItemWidth(150);
-                    ImGui::InputDouble("##BuyPrice", &temp_entry.buyPrice, 0.0, 0.0, "%.2f");
+                        ImGui::Text("Avg Buy (USD):");
+                        ImGui::SameLine(135);
+                        ImGui::SetNextItemWidth(150);
+                        ImGui::InputDouble("##BuyPrice", &temp_entry.buyPrice, 0.0, 0.0, "%.2f");
 
-                    if(ImGui::Button("Update Portfolio")) {
-                        if(temp_entry.amount < 0) temp_entry.amount = 0;
-                        if(temp_entry.buyPrice < 0) temp_entry.buyPrice = 0;
+                        if(ImGui::Button("Update Portfolio")) {
+                            if(temp_entry.amount < 0) temp_entry.amount = 0;
+                            if(temp_entry.buyPrice < 0) temp_entry.buyPrice = 0;
                         
-                        portfolio[coins[selected_index].api_id] = temp_entry;
-                        save_portfolio(portfolio);
+                            portfolio[coins[selected_index].api_id] = temp_entry;
+                            save_portfolio(portfolio);
+                            coinLabelsDirty = true;
+                        }
+                    } else {
+                        ImGui::Text("Holdings: %.6f", temp_entry.amount);
+                        ImGui::SameLine();
+                        ImGui::TextDisabled("| Avg cost %s, from %zu trades", format_money(temp_entry.buyPrice), trades->time.size());
                     }
 
                     // Calculate PNL for specific coin
-                    if (current_data.current_price > 0.0 && temp_entry.amount > 0) {
-                        double currentVal = temp_entry.amount * current_data.current_price;
+                    if (current_data->current_price > 0.0 && temp_entry.amount > 0) {
+                        double currentVal = temp_entry.amount * current_data->current_price;
                         double costVal = temp_entry.amount * temp_entry.buyPrice;
                         double pnl = currentVal - costVal;
                         double pnlPercent = (costVal > 0) ? pnl / costVal * 100.0 : 0.0;
                         ImGui::Spacing();
-                        ImGui::Text("Current value: $%.2f", currentVal);
+                        ImGui::Text("Current value: %s", format_money(currentVal));
                         ImGui::SameLine();
 
                         ImGui::Text("| PNL: ");
                         ImGui::SameLine();
                         ImVec4 color = (pnl >= 0) ? ImVec4(0,1,0,1) : ImVec4(1,0,0,1);
-                        ImGui::TextColored(color, "$%.2f (%.2f%%)", pnl, pnlPercent);
+                        ImGui::TextColored(color, "%s (%.2f%%)", format_money(pnl), pnlPercent);
+                    }
+
+                    ImGui::Separator();
+                    ImGui::TextDisabled("Trades");
+
+                    ImGui::SetNextItemWidth(110);
+                    ImGui::Combo("##TradeSide", &tradeSide, TRADE_SIDE_LABELS, static_cast<int>(std::size(TRADE_SIDE_LABELS)));
+                    ImGui::SameLine();
+                    ImGui::SetNextItemWidth(110);
+                    if(ImGui::InputDouble("Amount##Trade", &tradeAmount, 0.0, 0.0, "%.6f")) {
+                        if(tradePrice == 0.0 && current_data->current_price > 0.0) {
+                            tradePrice = current_data->current_price;
+                        }
+                    }
+                    ImGui::SameLine();
+                    ImGui::SetNextItemWidth(110);
+                    ImGui::InputDouble("USD##TradePrice", &tradePrice, 0.0, 0.0, "%.2f");
+                    ImGui::SameLine();
+                    ImGui::SetNextItemWidth(80);
+                    ImGui::InputDouble("Fee##Trade", &tradeFee, 0.0, 0.0, "%.2f");
+                    ImGui::SameLine();
+                    if(ImGui::Button("Record Trade")) {
+                        Trade trade{c.api_id, static_cast<TradeSide>(tradeSide), tradeAmount, tradePrice, tradeFee, now_seconds()};
+                        // The first recorded trade carries any hand-entered holdings over as an opening transfer.
+                        // Both go in together: if the trade is rejected, the coin had no trades before, so
+                        // dropping its book undoes the opening transfer too.
+                        PortfolioEntry const& opening = portfolio[c.api_id];
+                        bool opened = !trades && opening.amount > 0.00001
+                            && ledger.append({c.api_id, TradeSide::TransferIn, opening.amount, opening.buyPrice, 0.0, trade.timestamp});
+                        bool recorded = ledger.append(trade);
+                        if(!recorded && opened) {
+                            ledger.erase(c.api_id);
+                        }
+                        if(recorded) {
+                            sync_from_ledger(c.api_id);
+                            temp_entry = portfolio[c.api_id];
+                            save_ledger(ledger);
+                            save_portfolio(portfolio);
+                            revalue_portfolio();
+                            coinLabelsDirty = true;
+                            tradeAmount = 0.0;
+                            tradeFee = 0.0;
+                            trades = ledger.columns(c.api_id);
+                        } else {
+                            status = "Trade rejected: check the amount against your holdings.";
+                        }
+                    }
+
+                    if(trades) {
+                        int method = static_cast<int>(ledger.method());
+                        ImGui::SetNextItemWidth(110);
+                        if(ImGui::Combo("Cost basis##Method", &method, COST_METHOD_LABELS, static_cast<int>(std::size(COST_METHOD_LABELS)))) {
+                            ledger.set_method(static_cast<CostMethod>(method));
+                            for(auto const& coin_id : ledger.coins()) {
+                                sync_from_ledger(coin_id);
+                            }
+                            temp_entry = portfolio[c.api_id];
+                            save_ledger(ledger);
+                            save_portfolio(portfolio);
+                            revalue_portfolio();
+                        }
+
+                        PositionState position = ledger.position(c.api_id);
+                        ImGui::SameLine();
+                        ImVec4 realizedColor = (position.realized_pnl >= 0) ? ImVec4(0,1,0,1) : ImVec4(1,0,0,1);
+                        ImGui::TextColored(realizedColor, "Realized: %s", format_money(position.realized_pnl));
+                        ImGui::SameLine();
+                        ImGui::TextDisabled("| Fees: %s", format_money(position.fees));
+
+                        // Newest first; the columns are read in place, so this costs nothing per frame beyond the rows shown.
+                        std::size_t shown = std::min<std::size_t>(trades->time.size(), 20);
+                        if(ImGui::BeginTable("Trades", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchSame)) {
+                            for(std::size_t k = 0; k < shown; k++) {
+                                std::size_t t = trades->time.size() - 1 - k;
+                                auto when = std::chrono::sys_seconds(std::chrono::seconds(static_cast<long long>(trades->time[t])));
+                                ImGui::TableNextColumn();
+                                ImGui::TextDisabled("%s", frame_arena.format("{:%F %R}", when));
+                                ImGui::TableNextColumn();
+                                ImGui::Text("%s", trade_side_name(trades->side[t]));
+                                ImGui::TableNextColumn();
+                                ImGui::Text("%.6f", trades->amount[t]);
+                                ImGui::TableNextColumn();
+                                ImGui::Text("%s", format_money(trades->price[t]));
+                                ImGui::TableNextColumn();
+                                ImGui::TextDisabled("fee %s", format_money(trades->fee[t]));
+                            }
+                            ImGui::EndTable();
+                        }
+                    }
+
+                    ImGui::Separator();
+                    ImGui::TextDisabled("Alerts");
+
+                    // The rule list only changes on add/remove or coin switch, so cache it between frames.
+                    if(coinAlertsDirty || coinAlertsFor != c.api_id) {
+                        coinAlerts = alerts.rules_for(c.api_id);
+                        coinAlertLabels.clear();
+                        for(auto const& rule : coinAlerts) {
+                            coinAlertLabels.push_back(describe_alert(rule));
+                        }
+                        coinAlertsFor = c.api_id;
+                        coinAlertsDirty = false;
+                    }
+
+                    ImGui::SetNextItemWidth(150);
+                    ImGui::Combo("##AlertKind", &newAlertKind, ALERT_KIND_LABELS, static_cast<int>(std::size(ALERT_KIND_LABELS)));
+                    AlertKind kind = static_cast<AlertKind>(newAlertKind);
+                    if(kind == AlertKind::PriceAbove || kind == AlertKind::PriceBelow || kind == AlertKind::PercentMove) {
+                        ImGui::SameLine();
+                        ImGui::SetNextItemWidth(120);
+                        ImGui::InputDouble(kind == AlertKind::PercentMove ? "%##AlertThreshold" : "USD##AlertThreshold", &newAlertThreshold, 0.0, 0.0, "%.2f");
+                    }
+                    if(kind == AlertKind::PercentMove) {
+                        ImGui::SameLine();
+                        ImGui::SetNextItemWidth(80);
+                        ImGui::InputInt("min##AlertWindow", &newAlertWindowMinutes, 0);
+                    }
+                    ImGui::SameLine();
+                    if(ImGui::Button("Add Alert")) {
+                        AlertRule rule;
+                        rule.coin_id = c.api_id;
+                        rule.kind = kind;
+                        rule.threshold = newAlertThreshold;
+                        rule.window_seconds = std::max(newAlertWindowMinutes, 1) * 60;
+                        alerts.add_rule(rule);
+                        save_alerts(alerts.rules());
+                        coinAlertsDirty = true;
+                    }
+
+                    for(size_t a = 0; a < coinAlerts.size(); a++) {
+                        ImGui::PushID(static_cast<int>(coinAlerts[a].id));
+                        if(ImGui::SmallButton("x")) {
+                            alerts.remove_rule(coinAlerts[a].id);
+                            save_alerts(alerts.rules());
+                            coinAlertsDirty = true;
+                        }
+                        ImGui::SameLine();
+                        ImGui::Text("%s", coinAlertLabels[a].c_str());
+                        ImGui::PopID();
                     }
                 }
             }
@@ -436,6 +1262,7 @@ int main() {
             ImGui::OpenPopup("Add Coin");
             openSearchPopup = false;
             search_results.clear();
+            search_labels.clear();
             memset(search_buffer, 0, sizeof(search_buffer));
         }
 
@@ -455,9 +1282,9 @@ int main() {
 
             ImGui::Separator();
             ImGui::BeginChild("SearchResult", ImVec2(300, 200), true);
-            for(auto const& res : search_results) {
-                std::string label = std::format("{} ({})", res.name, res.ticker);
-                if(ImGui::Selectable(label.c_str())) {
+            for(size_t r = 0; r < search_results.size(); r++) {
+                auto const& res = search_results[r];
+                if(ImGui::Selectable(search_labels[r].c_str())) {
                     // Check if the coin already exists in the portfolio to avoid duplicates.
                     bool exists = false;
                     for(auto const& existing : coins) {
@@ -468,7 +1295,10 @@ int main() {
                     }
                     if(!exists) {
                         coins.push_back(res);
+                        allIds.push_back(res.api_id);
+                        scheduler.track(res.api_id, now_seconds());
                         save_coins(coins);
+                        coinLabelsDirty = true;
                     }
                     ImGui::CloseCurrentPopup();
                 }
@@ -479,6 +1309,27 @@ int main() {
                 
         ImGui::End(); 
 
+        if(ImGui::IsKeyPressed(ImGuiKey_F1)) {
+            showDebugOverlay = !showDebugOverlay;
+        }
+        if(showDebugOverlay) {
+            ImGui::SetNextWindowPos(ImVec2(10, (float)window.getSize().y - 88 - 18.0f * providerHealth.size()));
+            ImGui::SetNextWindowBgAlpha(0.6f);
+            ImGui::Begin("##DebugOverlay", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoMove);
+            ImGui::Text("Heap allocs last frame: %llu", static_cast<unsigned long long>(lastFrameAllocs));
+            ImGui::Text("Frame arena: %zu / %zu bytes", frame_arena.used(), frame_arena.capacity());
+            for(auto const& health : providerHealth) {
+                ImGui::Text("%s: p95 %.0f ms, %.0f%% ok, %llu/%llu won", health.name.c_str(), health.p95_ms, health.success_rate * 100.0,
+                    static_cast<unsigned long long>(health.wins), static_cast<unsigned long long>(health.requests));
+            }
+            if(board) {
+                ImGui::Text("Price board: %zu coins, %llu updates", board->coin_count(), static_cast<unsigned long long>(boardPublishes));
+            } else {
+                ImGui::TextDisabled("Price board: not attached");
+            }
+            ImGui::End();
+        }
+
         // --- Rendering ---
         window.clear();
         ImGui::SFML::Render(window);
@@ -486,6 +1337,11 @@ int main() {
     }
 
     // --- Shutdown ---
+    if(futureSave.valid()) {
+        futureSave.wait();
+    }
+    save_snapshot(make_snapshot());
+
     ImPlot::DestroyContext();
     ImGui::SFML::Shutdown();
     return 0;
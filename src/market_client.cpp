@@ -1,14 +1,58 @@
 #include "market_client.hpp"
 #include <cpr/cpr.h>
 #include <nlohmann/json.hpp>
-#include <print>
+#include "logger.hpp"
+#include "json_stream.hpp"
 #include <format>
-#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iterator>
 
 
 using json = nlohmann::json;
 
+namespace {
+
+// Asks for a compressed body. curl inflates it before it reaches `r.text` or a write callback.
+cpr::AcceptEncoding compressed_transfer() {
+    return {cpr::AcceptEncodingMethods::gzip, cpr::AcceptEncodingMethods::deflate};
+}
+
+// Row handlers for NumericRowStream: [timestamp_ms, price] and [timestamp_ms, open, high, low, close].
+// Rows with a null in a used column are skipped, so gaps in the API's data never reach the charts as NaN.
+NumericRowStream::RowCallback history_rows(std::vector<double>& times, std::vector<double>& prices) {
+    return [&times, &prices](std::span<const double> row) {
+        if(row.size() > 1 && std::isfinite(row[0]) && std::isfinite(row[1])) {
+            // Convert API's millisecond timestamp to seconds.
+            times.push_back(row[0] / 1000.0);
+            prices.push_back(row[1]);
+        }
+    };
+}
+
+NumericRowStream::RowCallback ohlc_rows(CoinData& data) {
+    return [&data](std::span<const double> candle) {
+        // Defensive check against malformed data points from the API.
+        if(candle.size() >= 5 && std::all_of(candle.begin(), candle.begin() + 5, [](double v) { return std::isfinite(v); })) {
+            data.time.push_back(candle[0] / 1000.0);
+            data.open.push_back(candle[1]);
+            data.high.push_back(candle[2]);
+            data.low.push_back(candle[3]);
+            data.close.push_back(candle[4]);
+        }
+    };
+}
+
+} // namespace
+
+MarketClient::MarketClient(std::string base_url) : base_url_(std::move(base_url)) {}
+
 std::map<std::string, double> MarketClient::get_multi_price(const std::vector<std::string>& coin_ids) {
+    return get_price_batch(coin_ids, {}).prices;
+}
+
+PriceBatch MarketClient::get_price_batch(const std::vector<std::string>& coin_ids, const std::vector<std::string>& vs_currencies, std::stop_token stop) {
     std::string joinsIds = "";
     // Build a comma-separated string of IDs, as required by the batch API endpoint.
     for (auto const& id : coin_ids) {
@@ -17,18 +61,38 @@ std::map<std::string, double> MarketClient::get_multi_price(const std::vector<st
         joinsIds += id;
     }
 
-    std::println("Batch fetching : {}", joinsIds); // DEBUG
+    // Every quote currency rides along in the same request; cross rates are then derived locally.
+    std::string currencies = BASE_CURRENCY;
+    for(auto const& currency : vs_currencies) {
+        if(currency != BASE_CURRENCY) {
+            currencies += ",";
+            currencies += currency;
+        }
+    }
+
+    LOG_DEBUG("Batch fetching {} coins", coin_ids.size());
 
-    std::string url = std::format("https://api.coingecko.com/api/v3/simple/price?ids={}&vs_currencies=usd", joinsIds);
+    std::string url = std::format("{}/simple/price?ids={}&vs_currencies={}", base_url_, joinsIds, currencies);
     
     // WARNING: Disabling SSL verification is insecure. For production, use a proper certificate bundle.
-    cpr::Response r = cpr::Get(cpr::Url{url}, cpr::VerifySsl(false));
+    // curl polls the progress callback even while the transfer stalls, so returning false aborts a hung request too.
+    cpr::Response r = cpr::Get(cpr::Url{url}, cpr::VerifySsl(false), compressed_transfer(),
+        cpr::ProgressCallback{[stop](cpr::cpr_off_t, cpr::cpr_off_t, cpr::cpr_off_t, cpr::cpr_off_t, intptr_t) { return !stop.stop_requested(); }});
 
+    if(stop.stop_requested()) return {};
     if(r.status_code == 200) {
-        return parse_multi_price(r.text);
+        auto quotes = parse_multi_quote(r.text);
+        PriceBatch batch{{}, FxMatrix::from_quotes(quotes, BASE_CURRENCY)};
+        for(auto const& [id, prices] : quotes) {
+            auto it = prices.find(BASE_CURRENCY);
+            if(it != prices.end()) {
+                batch.prices[id] = it->second;
+            }
+        }
+        return batch;
     } 
     
-    std::println(stderr, "Price Error: Status {}", r.status_code);
+    LOG_WARN("Price Error: Status {}", r.status_code);
     return {};
 
 }
@@ -38,8 +102,8 @@ std::map<std::string, double> MarketClient::parse_multi_price(const std::string&
     try {
         auto parsed = json::parse(json_body);
         for(auto& [key, value] : parsed.items()) {
-            if(value.contains("usd")) {
-                results[key] = value["usd"];
+            if(value.contains(BASE_CURRENCY)) {
+                results[key] = value[BASE_CURRENCY];
             }
         }
 
@@ -50,72 +114,223 @@ std::map<std::string, double> MarketClient::parse_multi_price(const std::string&
     return results;
 }
 
+std::map<std::string, std::map<std::string, double>> MarketClient::parse_multi_quote(const std::string& json_body) {
+    std::map<std::string, std::map<std::string, double>> results;
+    try {
+        auto parsed = json::parse(json_body);
+        for(auto& [coin, quotes] : parsed.items()) {
+            if(!quotes.is_object()) continue;
+            for(auto& [currency, price] : quotes.items()) {
+                if(price.is_number()) {
+                    results[coin][currency] = price.get<double>();
+                }
+            }
+        }
+    } catch(...) {
+        // Silently fail on parse error. The caller is expected to handle an empty map.
+    }
+
+    return results;
+}
+
+std::vector<MarketSummary> MarketClient::parse_markets(const std::string& json_body) {
+    std::vector<MarketSummary> results;
+    try {
+        auto parsed = json::parse(json_body);
+        if(!parsed.is_array()) return results;
+
+        results.reserve(parsed.size());
+        for(auto const& row : parsed) {
+            if(!row.contains("id") || !row["id"].is_string()) continue;
+
+            MarketSummary summary;
+            summary.id = row["id"].get<std::string>();
+            // Freshly listed coins report null for fields the API has not computed yet.
+            if(row.contains("current_price") && row["current_price"].is_number()) {
+                summary.current_price = row["current_price"].get<double>();
+            }
+            if(row.contains("price_change_percentage_24h") && row["price_change_percentage_24h"].is_number()) {
+                summary.change_24h = row["price_change_percentage_24h"].get<double>();
+            }
+            if(row.contains("sparkline_in_7d") && row["sparkline_in_7d"].contains("price")) {
+                auto const& prices = row["sparkline_in_7d"]["price"];
+                summary.sparkline.reserve(prices.size());
+                for(auto const& price : prices) {
+                    if(price.is_number()) summary.sparkline.push_back(price.get<double>());
+                }
+            }
+            results.push_back(std::move(summary));
+        }
+    } catch(...) {
+        // Silently fail on parse error, returning whatever was parsed so far.
+    }
+    return results;
+}
+
+std::vector<MarketSummary> MarketClient::get_markets(const std::vector<std::string>& coin_ids) {
+    std::vector<MarketSummary> results;
+    results.reserve(coin_ids.size());
+
+    // The ids filter is split into pages so neither the URL nor a single response grows unbounded.
+    for(std::size_t start = 0; start < coin_ids.size(); start += MARKETS_PAGE_SIZE) {
+        std::string joinsIds = "";
+        for(std::size_t i = start; i < std::min(start + MARKETS_PAGE_SIZE, coin_ids.size()); i++) {
+            if(!joinsIds.empty())
+                joinsIds += ",";
+            joinsIds += coin_ids[i];
+        }
+
+        LOG_DEBUG("Markets fetching page of {} coins", std::min(MARKETS_PAGE_SIZE, coin_ids.size() - start));
+
+        std::string url = std::format("{}/coins/markets?vs_currency={}&ids={}&sparkline=true&price_change_percentage=24h&per_page={}&page=1",
+            base_url_, BASE_CURRENCY, joinsIds, MARKETS_PAGE_SIZE);
+        // WARNING: Disabling SSL verification is insecure. For production, use a proper certificate bundle.
+        cpr::Response r = cpr::Get(cpr::Url{url}, cpr::VerifySsl(false), compressed_transfer());
+
+        if(r.status_code != 200) {
+            LOG_WARN("Markets Error: Status {}", r.status_code);
+            continue;
+        }
+        auto page = parse_markets(r.text);
+        std::move(page.begin(), page.end(), std::back_inserter(results));
+    }
+    return results;
+}
+
 std::optional<CoinData> MarketClient::parse_coin_price(const std::string& json_body, const std::string& coin_id) {
     try {
         auto parsed = json::parse(json_body);
         
         // API response nests the price inside an object with the coin's ID as the key.
-        if(parsed.contains(coin_id) && parsed[coin_id].contains("usd")) {
-            double price = parsed[coin_id]["usd"];
+        if(parsed.contains(coin_id) && parsed[coin_id].contains(BASE_CURRENCY)) {
+            double price = parsed[coin_id][BASE_CURRENCY];
             return CoinData{coin_id, price};
         } 
     } catch (const std::exception& e) {
         // A malformed JSON string will throw, indicating a potential API or network issue.
-        std::println(stderr, "JSON Parsing Error: {}", e.what());
+        LOG_ERROR("JSON Parsing Error: {}", e.what());
     }
     return std::nullopt;
 }
 
 std::vector<double> MarketClient::parse_history(const std::string& json_body) {
+    std::vector<double> times;
     std::vector<double> prices;
-    try {
-        auto parsed = json::parse(json_body);
-        if(parsed.contains("prices")) {
-            for(auto const& point : parsed["prices"]) {
-                // The API returns pairs of [timestamp, price]. We only need the price.
-                if(point.size() > 1) {
-                    prices.push_back(point[1]);
-                }
-            }
-        }
-    } catch(...) {
-        // Silently fail on parse error; the chart will simply show "No data".
-    };
+    parse_history_points(json_body, times, prices);
     return prices;
-    
 }
 
-std::optional<CoinData> MarketClient::get_coin_data(const std::string& coin_id) {
+void MarketClient::parse_history_points(const std::string& json_body, std::vector<double>& times, std::vector<double>& prices) {
+    times.clear();
+    prices.clear();
+    NumericRowStream stream("prices", history_rows(times, prices));
+    if(!stream.feed(json_body) || !stream.complete()) {
+        // Silently fail on parse error; keep the two series the same length.
+        times.clear();
+        prices.clear();
+    }
+}
+
+long MarketClient::stream_get(const std::string& url, NumericRowStream& stream) const {
+    // The write callback receives the inflated body chunk by chunk, so parsing overlaps the download
+    // and the body is never held in full. Returning false from it aborts a malformed transfer early.
+    // WARNING: Disabling SSL verification is insecure. For production, use a proper certificate bundle.
+    cpr::Response r = cpr::Get(cpr::Url{url}, cpr::VerifySsl(false), compressed_transfer(),
+        cpr::WriteCallback{[&stream](const std::string_view& data, intptr_t) { return stream.feed(data); }});
 
-    std::println("Fetching data for: {}", coin_id); // DEBUG
+    if(r.status_code == 200 && (stream.failed() || !stream.complete())) return 0;
+    return r.status_code;
+}
 
-    std::string url = std::format("https://api.coingecko.com/api/v3/simple/price?ids={}&vs_currencies=usd", coin_id);
+std::optional<CoinData> MarketClient::fetch_current_price(const std::string& coin_id) {
+    std::string url = std::format("{}/simple/price?ids={}&vs_currencies={}", base_url_, coin_id, BASE_CURRENCY);
 
     // This is a blocking network call, intended to be run in a separate thread.
     // WARNING: Disabling SSL verification is insecure. For production, use a proper certificate bundle.
-    cpr::Response r = cpr::Get(cpr::Url{url}, cpr::VerifySsl(false));
+    cpr::Response r = cpr::Get(cpr::Url{url}, cpr::VerifySsl(false), compressed_transfer());
 
     if(r.status_code != 200) {
-        std::println(stderr, "Price Error [{}]: Status {}", coin_id, r.status_code);
+        LOG_WARN("Price Error [{}]: Status {}", coin_id, r.status_code);
         return std::nullopt;
     }
+    return parse_coin_price(r.text, coin_id);
+}
+
+std::optional<CoinData> MarketClient::get_coin_data(const std::string& coin_id) {
+
+    LOG_DEBUG("Fetching data for: {}", coin_id);
+
     // First, get the current price. If this fails, no point in getting history.
-    auto basic_data = parse_coin_price(r.text, coin_id);
+    auto basic_data = fetch_current_price(coin_id);
     if(!basic_data) return std::nullopt;
 
-    std::string history_url = std::format("https://api.coingecko.com/api/v3/coins/{}/market_chart?vs_currency=usd&days=1", coin_id);
-    cpr::Response history_r = cpr::Get(cpr::Url{history_url}, cpr::VerifySsl(false));
-    if(history_r.status_code == 200) {
-        basic_data->price_history = parse_history(history_r.text);
-        std::println("Success! Got {} history points for {}.", basic_data->price_history.size(), coin_id); // DEBUG
+    std::string history_url = std::format("{}/coins/{}/market_chart?vs_currency={}&days=1", base_url_, coin_id, BASE_CURRENCY);
+    // Points are parsed straight into the result while the response downloads.
+    NumericRowStream stream("prices", history_rows(basic_data->history_time, basic_data->price_history));
+    long status = stream_get(history_url, stream);
+    if(status == 200) {
+        LOG_DEBUG("Got {} history points for {}.", basic_data->price_history.size(), coin_id);
     }
     else {
-        std::println(stderr, "History Error [{}]: Status {}", coin_id, history_r.status_code);
+        basic_data->history_time.clear();
+        basic_data->price_history.clear();
+        LOG_WARN("History Error [{}]: Status {}", coin_id, status);
     }
     
     return basic_data;
 }
 
+std::optional<CoinData> MarketClient::refresh_coin_data(const CoinData& previous, std::optional<double> current_price) {
+    double now = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    if(previous.history_time.empty() || previous.history_time.size() != previous.price_history.size()
+        || now - previous.history_time.back() > HISTORY_WINDOW_SECONDS) {
+        return get_coin_data(previous.id);
+    }
+
+    auto data = current_price ? std::optional<CoinData>(CoinData{previous.id, *current_price}) : fetch_current_price(previous.id);
+    if(!data) return std::nullopt;
+
+    data->price_history = previous.price_history;
+    data->history_time = previous.history_time;
+    data->time = previous.time;
+    data->open = previous.open;
+    data->high = previous.high;
+    data->low = previous.low;
+    data->close = previous.close;
+
+    // Only the points after the last one we hold; within a day the API keeps the same 5-minute granularity.
+    double last = previous.history_time.back();
+    std::string range_url = std::format("{}/coins/{}/market_chart/range?vs_currency={}&from={:.0f}&to={:.0f}",
+        base_url_, previous.id, BASE_CURRENCY, std::floor(last) + 1, std::ceil(now));
+    std::vector<double> times;
+    std::vector<double> prices;
+    NumericRowStream stream("prices", history_rows(times, prices));
+    long status = stream_get(range_url, stream);
+
+    if(status == 200) {
+        std::size_t appended = 0;
+        for(std::size_t i = 0; i < times.size(); i++) {
+            if(times[i] > data->history_time.back()) {
+                data->history_time.push_back(times[i]);
+                data->price_history.push_back(prices[i]);
+                ++appended;
+            }
+        }
+        LOG_DEBUG("Appended {} history points for {}.", appended, previous.id);
+    } else {
+        // Keep the history we already have; the next refresh asks for the same range again.
+        LOG_WARN("History Error [{}]: Status {}", previous.id, status);
+    }
+
+    // Trim from the front so the series keeps covering the same window.
+    auto keep_from = std::lower_bound(data->history_time.begin(), data->history_time.end(), now - HISTORY_WINDOW_SECONDS);
+    auto dropped = keep_from - data->history_time.begin();
+    data->history_time.erase(data->history_time.begin(), keep_from);
+    data->price_history.erase(data->price_history.begin(), data->price_history.begin() + dropped);
+
+    return data;
+}
+
 std::vector<CoinDef> MarketClient::parse_search_result(const std::string& json_body) {
     std::vector<CoinDef> results;
     try {
@@ -146,66 +361,79 @@ std::vector<CoinDef> MarketClient::parse_search_result(const std::string& json_b
 }
 
 std::vector<CoinDef> MarketClient::search_coins(const std::string& query) {
-    std::println("Searching for: {}", query); // DEBUG
+    LOG_DEBUG("Searching for: {}", query);
 
-    std::string url = std::format("https://api.coingecko.com/api/v3/search?query={}", query);
+    std::string url = std::format("{}/search?query={}", base_url_, query);
     // WARNING: Disabling SSL verification is insecure. For production, use a proper certificate bundle.
-    cpr::Response r = cpr::Get(cpr::Url{url}, cpr::VerifySsl(false));
+    cpr::Response r = cpr::Get(cpr::Url{url}, cpr::VerifySsl(false), compressed_transfer());
 
     if(r.status_code == 200) {
         return parse_search_result(r.text);
     }
 
-    std::println(stderr, "Search Error: Status {}", r.status_code);
+    LOG_WARN("Search Error: Status {}", r.status_code);
     return {};
 }
 
 void MarketClient::parse_ohlc(const std::string& json_body, CoinData& data) {
-    try {
-        auto parsed = json::parse(json_body);
-
+    data.time.clear();
+    data.open.clear();
+    data.high.clear();
+    data.low.clear();
+    data.close.clear();
+
+    NumericRowStream stream("", ohlc_rows(data));
+    if(!stream.feed(json_body) || !stream.complete()) {
+        // Silently fail on parse error, leaving no half-parsed candles behind.
         data.time.clear();
         data.open.clear();
         data.high.clear();
         data.low.clear();
         data.close.clear();
-
-        if(parsed.is_array()) {
-            for(auto const& candle : parsed) {
-                // Defensive check against malformed data points from the API.
-                if(candle.size() >= 5) {
-                    // Convert API's millisecond timestamp to seconds.
-                    data.time.push_back(candle[0].get<double>() / 1000.0); // [0] is timestamp
-                    data.open.push_back(candle[1].get<double>());
-                    data.high.push_back(candle[2].get<double>());
-                    data.low.push_back(candle[3].get<double>());
-                    data.close.push_back(candle[4].get<double>());
-                }
-            }
-        }
-    } catch(...) {
-        // Silently fail on parse error.
     }
 }
 
 bool MarketClient::fetch_ohlc(const std::string& coin_id, CoinData& data) {
-    std::println("Fetching OHLC for: {}", coin_id);
+    LOG_DEBUG("Fetching OHLC for: {}", coin_id);
 
-    std::string url = std::format("https://api.coingecko.com/api/v3/coins/{}/ohlc?vs_currency=usd&days=1", coin_id);
-    cpr::Response r = cpr::Get(cpr::Url{url}, cpr::VerifySsl(false));
+    std::string url = std::format("{}/coins/{}/ohlc?vs_currency={}&days=1", base_url_, coin_id, BASE_CURRENCY);
 
-    if(r.status_code == 200) {
-        parse_ohlc(r.text, data);
+    data.time.clear();
+    data.open.clear();
+    data.high.clear();
+    data.low.clear();
+    data.close.clear();
+    NumericRowStream stream("", ohlc_rows(data));
+    long status = stream_get(url, stream);
+
+    if(status == 200) {
         return true;
     }
 
-    std::println(stderr, "OHLC Error [{}]: Status {}", coin_id, r.status_code);
+    data.time.clear();
+    data.open.clear();
+    data.high.clear();
+    data.low.clear();
+    data.close.clear();
+    LOG_WARN("OHLC Error [{}]: Status {}", coin_id, status);
     return false;
 
 }
 
-std::future<bool> MarketClient::fetch_ohlc_async(const std::string& coin_id, CoinData& data) {
-    return std::async(std::launch::async, [this, coin_id, &data]() {
-        return this->fetch_ohlc(coin_id, data);
+std::future<bool> MarketClient::fetch_ohlc_async(const std::string& coin_id, SnapshotSlot<CoinData>& slot) {
+    return std::async(std::launch::async, [this, coin_id, &slot]() {
+        CoinData candles;
+        if(!this->fetch_ohlc(coin_id, candles)) return false;
+
+        return slot.update([&](CoinData& next) {
+            // The user may have switched coins while the request was in flight.
+            if(next.id != coin_id) return false;
+            next.time = candles.time;
+            next.open = candles.open;
+            next.high = candles.high;
+            next.low = candles.low;
+            next.close = candles.close;
+            return true;
+        });
     });
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #include "persistence.hpp"
+#include "logger.hpp"
 #include <nlohmann/json.hpp>
 #include <fstream>
-#include <iostream>
+#include <filesystem>
+#include <algorithm>
 
 using json = nlohmann::json;
 
@@ -64,7 +66,7 @@ void save_portfolio(const std::map<std::string, PortfolioEntry>& portfolio) {
         std::ofstream file("portfolio.json");
         file << j.dump(4); // Use 4-space indentation for readability.
     } catch (...) {
-        std::cerr << "Error saving portfolio \n";
+        LOG_ERROR("Error saving portfolio");
     }
 }
 
@@ -84,7 +86,194 @@ std::map<std::string, PortfolioEntry> load_portfolio() {
         }
     } catch (...) {
         // Fail gracefully if file is corrupt/missing; a new one is created on next save.
-        std::cerr << "Error loading portfolio - No portfolio found (creating new file). \n";
+        LOG_INFO("Error loading portfolio - No portfolio found (creating new file).");
     }
     return portfolio;
+}
+
+void save_alerts(const std::vector<AlertRule>& rules) {
+    try {
+        json j = json::array();
+        for(auto const& rule : rules) {
+            j.push_back({
+                {"id", rule.id},
+                {"coin", rule.coin_id},
+                {"kind", alert_kind_name(rule.kind)},
+                {"threshold", rule.threshold},
+                {"window", rule.window_seconds},
+                {"short", rule.short_period},
+                {"long", rule.long_period}
+            });
+        }
+        std::ofstream file("alerts.json");
+        file << j.dump(4); // Use 4-space indentation for readability.
+    } catch (...) {
+        LOG_ERROR("Error saving alerts");
+    }
+}
+
+std::vector<AlertRule> load_alerts() {
+    std::vector<AlertRule> rules;
+    try {
+        std::ifstream file("alerts.json");
+        if(file.is_open()) {
+            json j;
+            file >> j;
+            for(auto const& element : j) {
+                auto kind = parse_alert_kind(element.value("kind", ""));
+                if(!kind) continue; // Skip rules written by a newer version.
+
+                AlertRule rule;
+                rule.id = element.value("id", std::uint64_t{0});
+                rule.coin_id = element["coin"].get<std::string>();
+                rule.kind = *kind;
+                rule.threshold = element["threshold"].get<double>();
+                rule.window_seconds = element.value("window", rule.window_seconds);
+                rule.short_period = element.value("short", rule.short_period);
+                rule.long_period = element.value("long", rule.long_period);
+                rules.push_back(rule);
+            }
+        }
+    } catch (...) {
+        // Fail gracefully if file is corrupt/missing; a new one is created on next save.
+        LOG_INFO("Error loading alerts - No alerts found.");
+    }
+    return rules;
+}
+
+void save_ledger(const Ledger& ledger) {
+    try {
+        // Stored column by column, like in memory: one array per field instead of an object per trade.
+        json coins = json::object();
+        for(auto const& coin_id : ledger.coins()) {
+            const Ledger::Columns* trades = ledger.columns(coin_id);
+            std::vector<int> sides;
+            sides.reserve(trades->side.size());
+            for(auto side : trades->side) {
+                sides.push_back(static_cast<int>(side));
+            }
+            coins[coin_id] = {
+                {"time", trades->time},
+                {"side", sides},
+                {"amount", trades->amount},
+                {"price", trades->price},
+                {"fee", trades->fee}
+            };
+        }
+        json j = {
+            {"method", cost_method_name(ledger.method())},
+            {"coins", coins}
+        };
+        std::ofstream file("ledger.json");
+        file << j.dump();
+    } catch (...) {
+        LOG_ERROR("Error saving ledger");
+    }
+}
+
+Ledger load_ledger() {
+    Ledger ledger;
+    try {
+        std::ifstream file("ledger.json");
+        if(file.is_open()) {
+            json j;
+            file >> j;
+            ledger.set_method(parse_cost_method(j.value("method", "")).value_or(CostMethod::Fifo));
+            for(auto& [coin_id, columns] : j["coins"].items()) {
+                auto time = columns["time"].get<std::vector<double>>();
+                auto side = columns["side"].get<std::vector<int>>();
+                auto amount = columns["amount"].get<std::vector<double>>();
+                auto price = columns["price"].get<std::vector<double>>();
+                auto fee = columns["fee"].get<std::vector<double>>();
+                std::size_t n = std::min({time.size(), side.size(), amount.size(), price.size(), fee.size()});
+                for(std::size_t i = 0; i < n; i++) {
+                    if(side[i] < 0 || side[i] > static_cast<int>(TradeSide::TransferOut)) continue;
+                    ledger.append({coin_id, static_cast<TradeSide>(side[i]), amount[i], price[i], fee[i], time[i]});
+                }
+            }
+        }
+    } catch (...) {
+        // Fail gracefully if file is corrupt/missing; a new one is created on next save.
+        LOG_INFO("Error loading ledger - No trades found.");
+    }
+    return ledger;
+}
+
+void save_snapshot(const AppSnapshot& snapshot, const std::string& path) {
+    try {
+        json coins = json::array();
+        for(auto const& data : snapshot.coins) {
+            coins.push_back({
+                {"id", data->id},
+                {"price", data->current_price},
+                {"history", data->price_history},
+                {"history_time", data->history_time},
+                {"time", data->time},
+                {"open", data->open},
+                {"high", data->high},
+                {"low", data->low},
+                {"close", data->close}
+            });
+        }
+        json j = {
+            {"version", 1},
+            {"saved_at", snapshot.saved_at},
+            {"prices", snapshot.prices},
+            {"fx", snapshot.fx_rates},
+            {"coins", coins}
+        };
+
+        // MessagePack keeps the file compact and fast to parse; it only has to round-trip through this app.
+        std::vector<std::uint8_t> bytes = json::to_msgpack(j);
+        std::string temp_path = path + ".tmp";
+        {
+            std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            file.close();
+            if(!file) {
+                LOG_ERROR("Error writing snapshot");
+                std::filesystem::remove(temp_path);
+                return;
+            }
+        }
+        // The rename replaces the old snapshot in one step; readers see either the old or the new file.
+        std::filesystem::rename(temp_path, path);
+    } catch (...) {
+        LOG_ERROR("Error saving snapshot");
+    }
+}
+
+std::optional<AppSnapshot> load_snapshot(const std::string& path) {
+    try {
+        std::ifstream file(path, std::ios::binary);
+        if(!file.is_open()) return std::nullopt;
+
+        json j = json::from_msgpack(file);
+        if(j.value("version", 0) != 1) return std::nullopt;
+
+        AppSnapshot snapshot;
+        snapshot.saved_at = j["saved_at"].get<double>();
+        snapshot.prices = j["prices"].get<std::map<std::string, double>>();
+        snapshot.fx_rates = j["fx"].get<std::map<std::string, double>>();
+        for(auto const& coin : j["coins"]) {
+            CoinData data;
+            data.id = coin["id"].get<std::string>();
+            data.current_price = coin["price"].get<double>();
+            data.price_history = coin["history"].get<std::vector<double>>();
+            // Older snapshots have no history timestamps; such coins are fully re-fetched on their first refresh.
+            data.history_time = coin.value("history_time", std::vector<double>{});
+            if(data.history_time.size() != data.price_history.size()) data.history_time.clear();
+            data.time = coin["time"].get<std::vector<double>>();
+            data.open = coin["open"].get<std::vector<double>>();
+            data.high = coin["high"].get<std::vector<double>>();
+            data.low = coin["low"].get<std::vector<double>>();
+            data.close = coin["close"].get<std::vector<double>>();
+            snapshot.coins.push_back(std::make_shared<const CoinData>(std::move(data)));
+        }
+        return snapshot;
+    } catch (...) {
+        // A missing or corrupt snapshot just means a cold start.
+        LOG_INFO("Error loading snapshot - starting cold.");
+    }
+    return std::nullopt;
 }
\ No newline at end of file
@@ -0,0 +1,398 @@
+#include "price_board.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <new>
+#include <string_view>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define PRICE_BOARD_HAS_SHM 1
+#else
+#define PRICE_BOARD_HAS_SHM 0
+#endif
+
+namespace {
+
+constexpr std::uint32_t BOARD_MAGIC = 0x4d544252; // "MTBR"
+constexpr std::uint32_t BOARD_VERSION = 1;
+constexpr std::size_t ID_WORDS = PRICE_BOARD_ID_LENGTH / sizeof(std::uint64_t);
+constexpr std::size_t CURRENCY_LENGTH = sizeof(std::uint64_t); // Currency codes are packed into one word.
+constexpr int READ_ATTEMPTS = 8; // Bounds every read, keeping readers wait-free.
+
+// The segment is shared between processes, so every field must be an address-free atomic.
+static_assert(std::atomic<double>::is_always_lock_free);
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+
+using Word = std::atomic<std::uint64_t>;
+
+// Seqlock write: the sequence is odd while the slot is being changed.
+template<typename Write>
+void write_slot(Word& seq, Write&& write) {
+    std::uint64_t start = seq.load(std::memory_order_relaxed);
+    seq.store(start + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    write();
+    seq.store(start + 2, std::memory_order_release);
+}
+
+// Seqlock read: succeeds once a read starts and ends on the same even sequence.
+template<typename Read>
+bool read_slot(const Word& seq, Read&& read) {
+    for(int attempt = 0; attempt < READ_ATTEMPTS; attempt++) {
+        std::uint64_t before = seq.load(std::memory_order_acquire);
+        if(before & 1) continue;
+        read();
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(seq.load(std::memory_order_relaxed) == before) return true;
+    }
+    return false;
+}
+
+void pack(std::string_view text, Word* words, std::size_t count) {
+    for(std::size_t w = 0; w < count; w++) {
+        std::uint64_t value = 0;
+        std::size_t offset = w * sizeof(value);
+        if(offset < text.size()) {
+            std::memcpy(&value, text.data() + offset, std::min(sizeof(value), text.size() - offset));
+        }
+        words[w].store(value, std::memory_order_relaxed);
+    }
+}
+
+std::string unpack(const Word* words, std::size_t count) {
+    char buffer[PRICE_BOARD_ID_LENGTH] = {};
+    count = std::min(count, ID_WORDS);
+    for(std::size_t w = 0; w < count; w++) {
+        std::uint64_t value = words[w].load(std::memory_order_relaxed);
+        std::memcpy(buffer + w * sizeof(value), &value, sizeof(value));
+    }
+    std::size_t length = count * sizeof(std::uint64_t);
+    return std::string(buffer, std::find(buffer, buffer + length, '\0'));
+}
+
+} // namespace
+
+struct alignas(64) BoardCoin {
+    Word seq;
+    Word id[ID_WORDS]; // Written once, before the slot is counted in `coin_count`.
+    std::atomic<double> price;
+    std::atomic<double> updated_at;
+    std::atomic<std::uint32_t> history_size;
+    std::atomic<double> history_time[PRICE_BOARD_HISTORY];
+    std::atomic<double> history_price[PRICE_BOARD_HISTORY];
+};
+
+struct alignas(64) BoardFx {
+    Word seq;
+    std::atomic<std::uint32_t> count;
+    Word currency[PRICE_BOARD_CURRENCIES];
+    std::atomic<double> rate[PRICE_BOARD_CURRENCIES];
+};
+
+struct alignas(64) BoardValuation {
+    Word seq;
+    std::atomic<double> net_worth;
+    std::atomic<double> cost_basis;
+    std::atomic<double> realized_pnl;
+    std::atomic<double> updated_at;
+};
+
+struct BoardLayout {
+    std::atomic<std::uint32_t> magic; // Stored last on creation, so readers never see a half-built board.
+    std::uint32_t version;
+    std::uint64_t size;
+    Word publishes;
+    std::atomic<double> heartbeat;
+    std::atomic<std::uint32_t> coin_count;
+    BoardValuation valuation;
+    BoardFx fx;
+    BoardCoin coins[PRICE_BOARD_COINS];
+};
+
+std::unique_ptr<PriceBoardWriter> PriceBoardWriter::create(const std::string& name) {
+#if PRICE_BOARD_HAS_SHM
+    // Always start from a fresh object. A segment left behind by a crashed collector is unlinked rather
+    // than reinitialised, so readers still mapping it see it go stale and reattach to the new one
+    // instead of reading slots that were reassigned under their cached coin indexes.
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if(fd < 0 && errno == EEXIST) {
+        int existing = shm_open(name.c_str(), O_RDWR, 0);
+        if(existing >= 0 && flock(existing, LOCK_EX | LOCK_NB) != 0 && errno == EWOULDBLOCK) {
+            LOG_ERROR("Price board {} is already owned by another collector", name);
+            close(existing);
+            return nullptr;
+        }
+        LOG_INFO("Replacing abandoned price board {}", name);
+        shm_unlink(name.c_str());
+        if(existing >= 0) close(existing);
+        fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    }
+    if(fd < 0) {
+        LOG_ERROR("Failed to create price board {}: {}", name, std::strerror(errno));
+        return nullptr;
+    }
+    // The lock lives as long as the descriptor, so a crashed collector's segment is recognised as abandoned.
+    if(flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        LOG_ERROR("Failed to lock price board {}: {}", name, std::strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+    if(ftruncate(fd, sizeof(BoardLayout)) != 0) {
+        LOG_ERROR("Failed to size price board {}: {}", name, std::strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+    void* memory = mmap(nullptr, sizeof(BoardLayout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(memory == MAP_FAILED) {
+        LOG_ERROR("Failed to map price board {}: {}", name, std::strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+
+    // Nobody else can have this object mapped yet; readers reject it until the magic is stored.
+    auto* board = new (memory) BoardLayout();
+    board->version = BOARD_VERSION;
+    board->size = sizeof(BoardLayout);
+    board->magic.store(BOARD_MAGIC, std::memory_order_release);
+    LOG_INFO("Publishing price board {} ({} KiB)", name, sizeof(BoardLayout) / 1024);
+    return std::unique_ptr<PriceBoardWriter>(new PriceBoardWriter(name, fd, board));
+#else
+    LOG_ERROR("Price board {} needs POSIX shared memory, which this platform lacks", name);
+    return nullptr;
+#endif
+}
+
+PriceBoardWriter::PriceBoardWriter(std::string name, int fd, BoardLayout* board)
+    : name_(std::move(name)), fd_(fd), board_(board) {}
+
+PriceBoardWriter::~PriceBoardWriter() {
+#if PRICE_BOARD_HAS_SHM
+    munmap(board_, sizeof(BoardLayout));
+    shm_unlink(name_.c_str());
+    close(fd_);
+#endif
+}
+
+std::optional<std::size_t> PriceBoardWriter::slot_for(const std::string& coin_id) {
+    auto it = slots_.find(coin_id);
+    if(it != slots_.end()) return it->second;
+    if(coin_id.empty() || coin_id.size() > PRICE_BOARD_ID_LENGTH) return std::nullopt;
+
+    std::size_t slot = board_->coin_count.load(std::memory_order_relaxed);
+    if(slot >= PRICE_BOARD_COINS) return std::nullopt;
+    pack(coin_id, board_->coins[slot].id, ID_WORDS);
+    board_->coin_count.store(static_cast<std::uint32_t>(slot + 1), std::memory_order_release);
+    slots_.emplace(coin_id, slot);
+    return slot;
+}
+
+bool PriceBoardWriter::publish_price(const std::string& coin_id, double price, double at) {
+    auto slot = slot_for(coin_id);
+    if(!slot) return false;
+    BoardCoin& coin = board_->coins[*slot];
+    write_slot(coin.seq, [&] {
+        coin.price.store(price, std::memory_order_relaxed);
+        coin.updated_at.store(at, std::memory_order_relaxed);
+    });
+    return true;
+}
+
+bool PriceBoardWriter::publish_history(const std::string& coin_id, const std::vector<double>& times, const std::vector<double>& prices) {
+    auto slot = slot_for(coin_id);
+    if(!slot) return false;
+    BoardCoin& coin = board_->coins[*slot];
+    std::size_t count = std::min({times.size(), prices.size(), PRICE_BOARD_HISTORY});
+    std::size_t time_offset = times.size() - count;
+    std::size_t price_offset = prices.size() - count;
+    write_slot(coin.seq, [&] {
+        for(std::size_t i = 0; i < count; i++) {
+            coin.history_time[i].store(times[time_offset + i], std::memory_order_relaxed);
+            coin.history_price[i].store(prices[price_offset + i], std::memory_order_relaxed);
+        }
+        coin.history_size.store(static_cast<std::uint32_t>(count), std::memory_order_relaxed);
+    });
+    return true;
+}
+
+void PriceBoardWriter::publish_fx(const std::map<std::string, double>& rates) {
+    BoardFx& fx = board_->fx;
+    write_slot(fx.seq, [&] {
+        std::uint32_t count = 0;
+        for(auto const& [currency, rate] : rates) {
+            if(count >= PRICE_BOARD_CURRENCIES) break;
+            if(currency.empty() || currency.size() > CURRENCY_LENGTH) continue;
+            pack(currency, &fx.currency[count], 1);
+            fx.rate[count].store(rate, std::memory_order_relaxed);
+            ++count;
+        }
+        fx.count.store(count, std::memory_order_relaxed);
+    });
+}
+
+void PriceBoardWriter::publish_valuation(const PortfolioValuation& valuation) {
+    BoardValuation& slot = board_->valuation;
+    write_slot(slot.seq, [&] {
+        slot.net_worth.store(valuation.net_worth, std::memory_order_relaxed);
+        slot.cost_basis.store(valuation.cost_basis, std::memory_order_relaxed);
+        slot.realized_pnl.store(valuation.realized_pnl, std::memory_order_relaxed);
+        slot.updated_at.store(valuation.updated_at, std::memory_order_relaxed);
+    });
+}
+
+void PriceBoardWriter::heartbeat(double at) {
+    board_->heartbeat.store(at, std::memory_order_relaxed);
+}
+
+void PriceBoardWriter::commit(double at) {
+    heartbeat(at);
+    board_->publishes.fetch_add(1, std::memory_order_release);
+}
+
+std::unique_ptr<PriceBoardReader> PriceBoardReader::attach(const std::string& name) {
+#if PRICE_BOARD_HAS_SHM
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if(fd < 0) {
+        LOG_DEBUG("No price board at {}", name);
+        return nullptr;
+    }
+    struct stat info{};
+    if(fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(BoardLayout)) {
+        close(fd);
+        LOG_WARN("Price board {} has an unexpected size; ignoring it", name);
+        return nullptr;
+    }
+    void* memory = mmap(nullptr, sizeof(BoardLayout), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // The mapping stays valid without the descriptor.
+    if(memory == MAP_FAILED) {
+        LOG_WARN("Failed to map price board {}: {}", name, std::strerror(errno));
+        return nullptr;
+    }
+
+    auto const* board = static_cast<const BoardLayout*>(memory);
+    if(board->magic.load(std::memory_order_acquire) != BOARD_MAGIC || board->version != BOARD_VERSION || board->size != sizeof(BoardLayout)) {
+        munmap(memory, sizeof(BoardLayout));
+        LOG_WARN("Price board {} was written by an incompatible collector; ignoring it", name);
+        return nullptr;
+    }
+    LOG_INFO("Attached to price board {}", name);
+    return std::unique_ptr<PriceBoardReader>(new PriceBoardReader(board));
+#else
+    return nullptr;
+#endif
+}
+
+PriceBoardReader::PriceBoardReader(const BoardLayout* board) : board_(board) {}
+
+PriceBoardReader::~PriceBoardReader() {
+#if PRICE_BOARD_HAS_SHM
+    munmap(const_cast<BoardLayout*>(board_), sizeof(BoardLayout));
+#endif
+}
+
+std::uint64_t PriceBoardReader::publishes() const {
+    return board_->publishes.load(std::memory_order_acquire);
+}
+
+double PriceBoardReader::heartbeat() const {
+    return board_->heartbeat.load(std::memory_order_relaxed);
+}
+
+std::size_t PriceBoardReader::coin_count() const {
+    return std::min<std::size_t>(board_->coin_count.load(std::memory_order_acquire), PRICE_BOARD_COINS);
+}
+
+std::optional<std::size_t> PriceBoardReader::slot_of(const std::string& coin_id) const {
+    auto it = slots_.find(coin_id);
+    if(it != slots_.end()) return it->second;
+
+    std::size_t count = coin_count();
+    if(count == indexed_) return std::nullopt;
+    for(std::size_t slot = indexed_; slot < count; slot++) {
+        slots_.emplace(unpack(board_->coins[slot].id, ID_WORDS), slot);
+    }
+    indexed_ = count;
+
+    it = slots_.find(coin_id);
+    if(it == slots_.end()) return std::nullopt;
+    return it->second;
+}
+
+std::optional<BoardQuote> PriceBoardReader::quote(const std::string& coin_id) const {
+    auto slot = slot_of(coin_id);
+    if(!slot) return std::nullopt;
+    const BoardCoin& coin = board_->coins[*slot];
+
+    BoardQuote quote;
+    bool ok = read_slot(coin.seq, [&] {
+        quote.price = coin.price.load(std::memory_order_relaxed);
+        quote.updated_at = coin.updated_at.load(std::memory_order_relaxed);
+    });
+    // A slot claimed for its history alone has no price yet.
+    if(!ok || quote.updated_at <= 0.0) return std::nullopt;
+    return quote;
+}
+
+bool PriceBoardReader::history(const std::string& coin_id, std::vector<double>& times, std::vector<double>& prices) const {
+    auto slot = slot_of(coin_id);
+    if(!slot) return false;
+    const BoardCoin& coin = board_->coins[*slot];
+
+    bool ok = read_slot(coin.seq, [&] {
+        std::size_t count = std::min<std::size_t>(coin.history_size.load(std::memory_order_relaxed), PRICE_BOARD_HISTORY);
+        times.resize(count);
+        prices.resize(count);
+        for(std::size_t i = 0; i < count; i++) {
+            times[i] = coin.history_time[i].load(std::memory_order_relaxed);
+            prices[i] = coin.history_price[i].load(std::memory_order_relaxed);
+        }
+    });
+    if(!ok) {
+        times.clear();
+        prices.clear();
+    }
+    return ok && !times.empty();
+}
+
+std::optional<PortfolioValuation> PriceBoardReader::valuation() const {
+    const BoardValuation& slot = board_->valuation;
+    PortfolioValuation valuation;
+    bool ok = read_slot(slot.seq, [&] {
+        valuation.net_worth = slot.net_worth.load(std::memory_order_relaxed);
+        valuation.cost_basis = slot.cost_basis.load(std::memory_order_relaxed);
+        valuation.realized_pnl = slot.realized_pnl.load(std::memory_order_relaxed);
+        valuation.updated_at = slot.updated_at.load(std::memory_order_relaxed);
+    });
+    if(!ok || valuation.updated_at <= 0.0) return std::nullopt;
+    return valuation;
+}
+
+std::map<std::string, double> PriceBoardReader::fx_rates() const {
+    const BoardFx& fx = board_->fx;
+    std::uint64_t currencies[PRICE_BOARD_CURRENCIES];
+    double rates[PRICE_BOARD_CURRENCIES];
+    std::size_t count = 0;
+    bool ok = read_slot(fx.seq, [&] {
+        count = std::min<std::size_t>(fx.count.load(std::memory_order_relaxed), PRICE_BOARD_CURRENCIES);
+        for(std::size_t i = 0; i < count; i++) {
+            currencies[i] = fx.currency[i].load(std::memory_order_relaxed);
+            rates[i] = fx.rate[i].load(std::memory_order_relaxed);
+        }
+    });
+
+    std::map<std::string, double> result;
+    if(!ok) return result;
+    for(std::size_t i = 0; i < count; i++) {
+        char code[CURRENCY_LENGTH];
+        std::memcpy(code, &currencies[i], sizeof(code));
+        result[std::string(code, std::find(code, code + sizeof(code), '\0'))] = rates[i];
+    }
+    return result;
+}
@@ -0,0 +1,238 @@
+#include "price_provider.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <thread>
+
+namespace {
+
+constexpr std::size_t LATENCY_SAMPLES = 64;
+constexpr double SUCCESS_DECAY = 0.8; // Weight of the history in the success rate; 0.2 goes to the latest request.
+
+} // namespace
+
+CoinGeckoProvider::CoinGeckoProvider(std::string base_url, std::string name)
+    : name_(std::move(name)), client_(std::move(base_url)) {}
+
+std::optional<PriceBatch> CoinGeckoProvider::fetch_prices(const std::vector<std::string>& coin_ids, const std::vector<std::string>& vs_currencies, std::stop_token stop) {
+    PriceBatch batch = client_.get_price_batch(coin_ids, vs_currencies, stop);
+    if(batch.prices.empty()) return std::nullopt;
+    return batch;
+}
+
+StaticPriceProvider::StaticPriceProvider(std::string name, std::map<std::string, std::map<std::string, double>> quotes)
+    : name_(std::move(name)), quotes_(std::move(quotes)) {}
+
+std::optional<PriceBatch> StaticPriceProvider::fetch_prices(const std::vector<std::string>& coin_ids, const std::vector<std::string>& vs_currencies, std::stop_token stop) {
+    // Sleep in a way a stop can interrupt, like an aborted transfer.
+    std::mutex mutex;
+    std::condition_variable_any wake;
+    std::unique_lock lock(mutex);
+    wake.wait_for(lock, stop, std::chrono::milliseconds(delay_ms_.load(std::memory_order_relaxed)), [] { return false; });
+    if(stop.stop_requested() || failing_.load(std::memory_order_relaxed)) return std::nullopt;
+
+    // Answer exactly what a real provider would: only the requested coins and currencies.
+    std::map<std::string, std::map<std::string, double>> answered;
+    for(auto const& id : coin_ids) {
+        auto coin = quotes_.find(id);
+        if(coin == quotes_.end()) continue;
+        for(auto const& [currency, price] : coin->second) {
+            bool wanted = currency == MarketClient::BASE_CURRENCY
+                || std::find(vs_currencies.begin(), vs_currencies.end(), currency) != vs_currencies.end();
+            if(wanted) answered[id][currency] = price;
+        }
+    }
+
+    PriceBatch batch{{}, FxMatrix::from_quotes(answered, MarketClient::BASE_CURRENCY)};
+    for(auto const& [id, prices] : answered) {
+        auto it = prices.find(MarketClient::BASE_CURRENCY);
+        if(it != prices.end()) batch.prices[id] = it->second;
+    }
+    if(batch.prices.empty()) return std::nullopt;
+    return batch;
+}
+
+void HedgedPriceSource::Tracker::record(bool ok, double latency_ms) {
+    std::lock_guard lock(mutex);
+    ++requests;
+    success_rate = SUCCESS_DECAY * success_rate + (1.0 - SUCCESS_DECAY) * (ok ? 1.0 : 0.0);
+    if(ok) {
+        latencies_ms.push_back(latency_ms);
+        if(latencies_ms.size() > LATENCY_SAMPLES) latencies_ms.pop_front();
+    }
+}
+
+void HedgedPriceSource::Tracker::record_stopped(double latency_ms) {
+    std::lock_guard lock(mutex);
+    ++requests;
+    latencies_ms.push_back(latency_ms);
+    if(latencies_ms.size() > LATENCY_SAMPLES) latencies_ms.pop_front();
+}
+
+double HedgedPriceSource::Tracker::p95_ms() const {
+    if(latencies_ms.empty()) return 0.0;
+    std::vector<double> sorted(latencies_ms.begin(), latencies_ms.end());
+    std::size_t rank = (sorted.size() * 95 + 99) / 100 - 1;
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    return sorted[rank];
+}
+
+HedgedPriceSource::HedgedPriceSource(std::vector<std::shared_ptr<PriceProvider>> providers, HedgingOptions options)
+    : options_(options) {
+    for(auto& provider : providers) {
+        if(!provider) continue;
+        auto tracker = std::make_shared<Tracker>();
+        tracker->provider = std::move(provider);
+        trackers_.push_back(std::move(tracker));
+    }
+    // One worker per provider lets a request hedge across all of them at once.
+    for(std::size_t i = 0; i < trackers_.size(); i++) {
+        workers_.emplace_back([this](std::stop_token stop) { run_worker(stop); });
+    }
+}
+
+HedgedPriceSource::~HedgedPriceSource() {
+    // Join before the queue and trackers the workers use go away. Queued attempts belong to finished requests.
+    workers_.clear();
+}
+
+void HedgedPriceSource::run_worker(std::stop_token stop) {
+    while(true) {
+        std::function<void()> attempt;
+        {
+            std::unique_lock lock(queue_mutex_);
+            if(!queue_ready_.wait(lock, stop, [this] { return !queue_.empty(); })) return;
+            attempt = std::move(queue_.front());
+            queue_.pop_front();
+        }
+        attempt();
+    }
+}
+
+double HedgedPriceSource::score(const Tracker& tracker) const {
+    std::lock_guard lock(tracker.mutex);
+    double p95 = tracker.latencies_ms.empty() ? static_cast<double>(options_.default_hedge_delay.count()) : tracker.p95_ms();
+    // Reliability first, then speed: a provider that answers half the time loses to a slower reliable one.
+    return tracker.success_rate * tracker.success_rate / (1.0 + p95 / 1000.0);
+}
+
+std::chrono::milliseconds HedgedPriceSource::hedge_delay(const Tracker& tracker) const {
+    std::lock_guard lock(tracker.mutex);
+    if(tracker.latencies_ms.empty()) return options_.default_hedge_delay;
+    auto p95 = std::chrono::milliseconds(static_cast<std::int64_t>(tracker.p95_ms()));
+    return std::clamp(p95, options_.min_hedge_delay, options_.timeout);
+}
+
+PriceBatch HedgedPriceSource::fetch_prices(const std::vector<std::string>& coin_ids, const std::vector<std::string>& vs_currencies) {
+    if(trackers_.empty()) return {};
+
+    std::vector<std::pair<double, std::shared_ptr<Tracker>>> order;
+    for(auto const& tracker : trackers_) {
+        order.emplace_back(score(*tracker), tracker);
+    }
+    std::stable_sort(order.begin(), order.end(), [](auto const& a, auto const& b) { return a.first > b.first; });
+
+    // Everything the attempts touch is shared, so a straggler stays valid after the request returns.
+    struct Race {
+        std::mutex mutex;
+        std::condition_variable done;
+        std::optional<PriceBatch> result;
+        std::shared_ptr<Tracker> winner;
+        int pending = 0;
+        std::stop_source stop; // Requested once the request is decided, to call off the other attempts.
+    };
+    auto race = std::make_shared<Race>();
+    auto ids = std::make_shared<const std::vector<std::string>>(coin_ids);
+    auto currencies = std::make_shared<const std::vector<std::string>>(vs_currencies);
+
+    auto launch = [&](std::shared_ptr<Tracker> tracker) {
+        {
+            std::lock_guard lock(race->mutex);
+            ++race->pending;
+        }
+        auto attempt = [race, tracker = std::move(tracker), ids, currencies]() {
+            std::stop_token stop = race->stop.get_token();
+            std::optional<PriceBatch> batch;
+            bool ok = false;
+            // An attempt still queued when the request was decided is not worth starting.
+            if(!stop.stop_requested()) {
+                auto start = std::chrono::steady_clock::now();
+                try {
+                    batch = tracker->provider->fetch_prices(*ids, *currencies, stop);
+                } catch(...) {
+                    // A throwing provider counts as a failed request.
+                }
+                double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                ok = batch && !batch->prices.empty();
+                if(!ok && stop.stop_requested()) {
+                    tracker->record_stopped(elapsed_ms);
+                } else {
+                    tracker->record(ok, elapsed_ms);
+                }
+            }
+
+            std::lock_guard lock(race->mutex);
+            --race->pending;
+            if(ok && !race->result) {
+                race->result = std::move(*batch);
+                race->winner = tracker;
+            }
+            race->done.notify_all();
+        };
+        {
+            std::lock_guard lock(queue_mutex_);
+            queue_.push_back(std::move(attempt));
+        }
+        queue_ready_.notify_one();
+    };
+
+    auto deadline = std::chrono::steady_clock::now() + options_.timeout;
+    std::size_t launched = 0;
+    launch(order[launched++].second);
+
+    while(true) {
+        // Wait for an answer, for every attempt in flight to fail, or until the last provider's p95 passes.
+        auto hedge_at = deadline;
+        if(launched < order.size()) {
+            hedge_at = std::min(deadline, std::chrono::steady_clock::now() + hedge_delay(*order[launched - 1].second));
+        }
+
+        std::unique_lock lock(race->mutex);
+        race->done.wait_until(lock, hedge_at, [&] { return race->result.has_value() || race->pending == 0; });
+
+        if(race->result) {
+            race->stop.request_stop();
+            std::lock_guard win(race->winner->mutex);
+            ++race->winner->wins;
+            return std::move(*race->result);
+        }
+        bool exhausted = launched >= order.size();
+        if(std::chrono::steady_clock::now() >= deadline || (exhausted && race->pending == 0)) {
+            race->stop.request_stop();
+            LOG_WARN("All price providers failed or timed out");
+            return {};
+        }
+        if(exhausted) continue;
+        lock.unlock();
+
+        LOG_DEBUG("Hedging price request to {}", order[launched].second->provider->name());
+        launch(order[launched++].second);
+    }
+}
+
+std::vector<ProviderHealth> HedgedPriceSource::health() const {
+    std::vector<ProviderHealth> result;
+    result.reserve(trackers_.size());
+    for(auto const& tracker : trackers_) {
+        ProviderHealth health;
+        health.name = tracker->provider->name();
+        health.score = score(*tracker);
+        std::lock_guard lock(tracker->mutex);
+        health.p95_ms = tracker->p95_ms();
+        health.success_rate = tracker->success_rate;
+        health.requests = tracker->requests;
+        health.wins = tracker->wins;
+        result.push_back(std::move(health));
+    }
+    return result;
+}
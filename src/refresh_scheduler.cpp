@@ -0,0 +1,196 @@
+#include "refresh_scheduler.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// How far each input may move a coin's interval away from the base, in either direction.
+constexpr double MIN_VOLATILITY_FACTOR = 0.25;
+constexpr double MAX_VOLATILITY_FACTOR = 4.0;
+constexpr double MIN_WEIGHT_FACTOR = 0.5;
+constexpr double MAX_WEIGHT_FACTOR = 4.0;
+constexpr double VISIBLE_FACTOR = 2.0;
+
+} // namespace
+
+RefreshScheduler::RefreshScheduler(RefreshOptions options)
+    : options_(options), tokens_(options.burst) {}
+
+void RefreshScheduler::track(const std::string& coin_id, double now) {
+    if(coins_.contains(coin_id)) return;
+    Coin& coin = coins_[coin_id];
+    dirty_ = true;
+    schedule(coin_id, coin, now);
+}
+
+void RefreshScheduler::untrack(const std::string& coin_id) {
+    // Its heap entries are left behind and dropped once they surface.
+    if(coins_.erase(coin_id) > 0) dirty_ = true;
+}
+
+void RefreshScheduler::set_volatility(const std::string& coin_id, double volatility) {
+    auto it = coins_.find(coin_id);
+    if(it == coins_.end() || !std::isfinite(volatility) || volatility < 0.0) return;
+    it->second.volatility = volatility;
+    dirty_ = true;
+}
+
+void RefreshScheduler::set_weight(const std::string& coin_id, double weight) {
+    auto it = coins_.find(coin_id);
+    if(it == coins_.end() || !std::isfinite(weight)) return;
+    weight = std::clamp(weight, 0.0, 1.0);
+    if(it->second.weight == weight) return;
+    it->second.weight = weight;
+    dirty_ = true;
+}
+
+void RefreshScheduler::set_visible(const std::string& coin_id, bool visible) {
+    auto it = coins_.find(coin_id);
+    if(it == coins_.end() || it->second.visible == visible) return;
+    it->second.visible = visible;
+    dirty_ = true;
+}
+
+double RefreshScheduler::mean_volatility() const {
+    double sum = 0.0;
+    std::size_t known = 0;
+    for(auto const& [coin_id, coin] : coins_) {
+        if(coin.volatility > 0.0) {
+            sum += coin.volatility;
+            ++known;
+        }
+    }
+    return known > 0 ? sum / static_cast<double>(known) : 0.0;
+}
+
+double RefreshScheduler::interval_for(const Coin& coin, double mean_volatility) const {
+    // Volatility counts relative to the other coins, so the base interval stays meaningful in calm and wild markets alike.
+    double volatility = 1.0;
+    if(coin.volatility > 0.0 && mean_volatility > 0.0) {
+        volatility = std::clamp(coin.volatility / mean_volatility, MIN_VOLATILITY_FACTOR, MAX_VOLATILITY_FACTOR);
+    }
+    // An equal share of the portfolio scores 1; coins not held poll at half the base rate.
+    double share = static_cast<double>(coins_.size()) * coin.weight;
+    double weight = std::clamp(0.5 + 0.5 * share, MIN_WEIGHT_FACTOR, MAX_WEIGHT_FACTOR);
+    double visible = coin.visible ? VISIBLE_FACTOR : 1.0;
+
+    return std::clamp(options_.base_interval / (volatility * weight * visible), options_.min_interval, options_.max_interval);
+}
+
+void RefreshScheduler::schedule(const std::string& coin_id, Coin& coin, double due) {
+    coin.due = due;
+    coin.version = ++next_version_;
+    queue_.push({due, coin.version, coin_id});
+}
+
+void RefreshScheduler::rebalance() {
+    if(!dirty_) return;
+    dirty_ = false;
+
+    // Drop accumulated stale entries once they outnumber the live ones.
+    bool compact = queue_.size() > 4 * coins_.size() + 16;
+    if(compact) queue_ = {};
+
+    double mean = mean_volatility();
+    for(auto& [coin_id, coin] : coins_) {
+        double interval = interval_for(coin, mean);
+        bool changed = interval != coin.interval;
+        coin.interval = interval;
+        if(coin.refreshed && changed) {
+            schedule(coin_id, coin, coin.last + interval);
+        } else if(compact) {
+            schedule(coin_id, coin, coin.due);
+        }
+    }
+}
+
+void RefreshScheduler::refill(double now) {
+    if(std::isnan(refilled_at_) || now < refilled_at_) {
+        refilled_at_ = now;
+        return;
+    }
+    tokens_ = std::min(options_.burst, tokens_ + (now - refilled_at_) * options_.requests_per_minute / 60.0);
+    refilled_at_ = now;
+}
+
+double RefreshScheduler::required_tokens(bool visible) const {
+    // The reserve can never be more than the bucket holds, or the batch would never go out.
+    return visible ? std::min(1.0 + options_.visible_reserve, std::max(options_.burst, 1.0)) : 1.0;
+}
+
+bool RefreshScheduler::pop_stale() {
+    while(!queue_.empty()) {
+        const Slot& top = queue_.top();
+        auto it = coins_.find(top.coin_id);
+        if(it != coins_.end() && it->second.version == top.version) return true;
+        queue_.pop();
+    }
+    return false;
+}
+
+std::vector<std::string> RefreshScheduler::take_due(double now) {
+    rebalance();
+    refill(now);
+    if(!pop_stale() || queue_.top().due > now || tokens_ < 1.0) return {};
+
+    std::vector<std::string> due;
+    bool visible = false;
+    for(auto const& [coin_id, coin] : coins_) {
+        if(!coin.refreshed || coin.due <= now || now - coin.last >= options_.coalesce * coin.interval) {
+            due.push_back(coin_id);
+            visible = visible || coin.visible;
+        }
+    }
+    if(tokens_ < required_tokens(visible)) return {};
+    tokens_ -= 1.0;
+    std::sort(due.begin(), due.end());
+
+    for(auto const& coin_id : due) {
+        Coin& coin = coins_[coin_id];
+        coin.last = now;
+        coin.refreshed = true;
+        schedule(coin_id, coin, now + coin.interval);
+    }
+    return due;
+}
+
+void RefreshScheduler::mark_refreshed(const std::vector<std::string>& coin_ids, double now, double requests) {
+    rebalance();
+    refill(now);
+    tokens_ = std::max(tokens_ - requests, -options_.burst);
+
+    for(auto const& coin_id : coin_ids) {
+        auto it = coins_.find(coin_id);
+        if(it == coins_.end()) continue;
+        it->second.last = now;
+        it->second.refreshed = true;
+        schedule(coin_id, it->second, now + it->second.interval);
+    }
+}
+
+bool RefreshScheduler::try_spend(double now, double requests) {
+    refill(now);
+    if(tokens_ < requests) return false;
+    tokens_ -= requests;
+    return true;
+}
+
+double RefreshScheduler::next_due(double now) {
+    rebalance();
+    refill(now);
+    if(!pop_stale()) return std::numeric_limits<double>::infinity();
+
+    double due = queue_.top().due;
+    double required = required_tokens(coins_.at(queue_.top().coin_id).visible);
+    if(tokens_ < required) {
+        if(options_.requests_per_minute <= 0.0) return std::numeric_limits<double>::infinity();
+        due = std::max(due, now + (required - tokens_) * 60.0 / options_.requests_per_minute);
+    }
+    return due;
+}
+
+double RefreshScheduler::interval(const std::string& coin_id) const {
+    auto it = coins_.find(coin_id);
+    if(it == coins_.end()) return 0.0;
+    return interval_for(it->second, mean_volatility());
+}
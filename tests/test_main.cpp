@@ -1,6 +1,29 @@
 #include <gtest/gtest.h>
 #include "market_client.hpp"
 #include "logic.hpp"
+#include "coin_cache.hpp"
+#include "compressed_series.hpp"
+#include "frame_arena.hpp"
+#include "alloc_counter.hpp"
+#include "alerts.hpp"
+#include "analysis.hpp"
+#include "logger.hpp"
+#include "ledger.hpp"
+#include "price_provider.hpp"
+#include "json_stream.hpp"
+#include "persistence.hpp"
+#include "refresh_scheduler.hpp"
+#include "price_board.hpp"
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 TEST(SetupTest, VersionCheck) {
     EXPECT_EQ(MarketConfig::get_app_version(), "MarketTracker v1.0");
@@ -27,4 +50,886 @@ TEST(MarketClientTest, HandlesMissingData) {
     std::string wrong_json = R"({"ethereum": {"usd": 3000.0}})";
     auto result = MarketClient::parse_coin_price(wrong_json, "bitcoin");
     EXPECT_FALSE(result.has_value());
-}
\ No newline at end of file
+}
+
+// Test snapshot publication keeps old readers consistent
+TEST(SnapshotSlotTest, ReadersKeepTheirVersion) {
+    SnapshotSlot<CoinData> slot;
+    slot.publish(CoinData{"bitcoin", 100.0});
+    auto pinned = slot.load();
+
+    slot.publish(CoinData{"ethereum", 200.0});
+    EXPECT_EQ(pinned->id, "bitcoin");
+    EXPECT_EQ(slot.load()->id, "ethereum");
+}
+
+// Test read-copy-update can abort without publishing
+TEST(SnapshotSlotTest, UpdateMergesOrAborts) {
+    SnapshotSlot<CoinData> slot;
+    slot.publish(CoinData{"bitcoin", 100.0, {1.0, 2.0}});
+
+    bool updated = slot.update([](CoinData& next) {
+        next.close = {3.0};
+        return true;
+    });
+    EXPECT_TRUE(updated);
+    EXPECT_EQ(slot.load()->price_history.size(), 2);
+    EXPECT_EQ(slot.load()->close.size(), 1);
+
+    auto before = slot.load();
+    EXPECT_FALSE(slot.update([](CoinData&) { return false; }));
+    EXPECT_EQ(slot.load(), before);
+}
+
+
+// Test the cache evicts the least recently used coin once over budget
+TEST(CoinCacheTest, EvictsLeastRecentlyUsed) {
+    auto make = [](const std::string& id) {
+        return std::make_shared<const CoinData>(CoinData{id, 1.0, std::vector<double>(100, 1.0)});
+    };
+    std::size_t one = CoinCache::approx_bytes(*make("bitcoin"));
+    CoinCache cache(one * 2);
+
+    cache.put(make("bitcoin"));
+    cache.put(make("ethereum"));
+    EXPECT_NE(cache.get("bitcoin"), nullptr); // bitcoin is now the most recent
+    cache.put(make("solana"));
+
+    EXPECT_TRUE(cache.contains("bitcoin"));
+    EXPECT_FALSE(cache.contains("ethereum"));
+    EXPECT_TRUE(cache.contains("solana"));
+    EXPECT_LE(cache.bytes_used(), one * 2);
+
+    auto entries = cache.entries();
+    ASSERT_EQ(entries.size(), 2);
+    EXPECT_EQ(entries[0]->id, "solana"); // Most recently used first.
+}
+
+// Test replacing an entry keeps accounting consistent
+TEST(CoinCacheTest, ReplaceAndErase) {
+    CoinCache cache;
+    cache.put(std::make_shared<const CoinData>(CoinData{"bitcoin", 1.0}));
+    cache.put(std::make_shared<const CoinData>(CoinData{"bitcoin", 2.0}));
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(cache.get("bitcoin")->current_price, 2.0);
+
+    cache.erase("bitcoin");
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(cache.bytes_used(), 0);
+    EXPECT_EQ(cache.get("bitcoin"), nullptr);
+}
+
+
+// Test the warm-start snapshot round-trips and a corrupt file means a cold start
+TEST(PersistenceTest, SnapshotRoundTripsAndRejectsCorruptFiles) {
+    auto dir = std::filesystem::temp_directory_path() / std::format("mt_snapshot_{}", std::chrono::steady_clock::now().time_since_epoch().count());
+    std::filesystem::create_directories(dir);
+    std::string path = (dir / "snapshot.msgpack").string();
+
+    AppSnapshot snapshot;
+    snapshot.saved_at = 1700000000.5;
+    snapshot.prices = {{"bitcoin", 65000.25}, {"ethereum", 3000.0}};
+    snapshot.fx_rates = {{"usd", 1.0}, {"eur", 0.92}};
+    CoinData coin{"bitcoin", 65000.25, {64000.0, 64500.0}, {1700000000.0, 1700000300.0}, {1.0}, {2.0}, {3.0}, {0.5}, {2.5}};
+    snapshot.coins.push_back(std::make_shared<const CoinData>(coin));
+    save_snapshot(snapshot, path);
+    EXPECT_FALSE(std::filesystem::exists(path + ".tmp"));
+
+    auto loaded = load_snapshot(path);
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->saved_at, snapshot.saved_at);
+    EXPECT_EQ(loaded->prices, snapshot.prices);
+    EXPECT_EQ(loaded->fx_rates, snapshot.fx_rates);
+    ASSERT_EQ(loaded->coins.size(), 1);
+    const CoinData& back = *loaded->coins[0];
+    EXPECT_EQ(back.id, "bitcoin");
+    EXPECT_EQ(back.current_price, coin.current_price);
+    EXPECT_EQ(back.price_history, coin.price_history);
+    EXPECT_EQ(back.history_time, coin.history_time);
+    EXPECT_EQ(back.close, coin.close);
+
+    // A truncated file (e.g. from a crash mid-write under the old in-place save) is rejected.
+    auto size = std::filesystem::file_size(path);
+    std::filesystem::resize_file(path, size / 2);
+    EXPECT_FALSE(load_snapshot(path).has_value());
+    EXPECT_FALSE(load_snapshot((dir / "missing.msgpack").string()).has_value());
+
+    std::filesystem::remove_all(dir);
+}
+
+// Test compressed series decodes back to the exact input
+TEST(CompressedSeriesTest, RoundTripsExactly) {
+    CompressedSeries series(64);
+    std::vector<double> expected_times;
+    std::vector<double> expected_values;
+    std::int64_t t = 1700000000000;
+    double price = 43000.0;
+    for(int i = 0; i < 1000; i++) {
+        t += 300000 + (i % 7) * 13 - 40; // 5 minute candles with some jitter
+        price += (i % 3 == 0) ? 0.0 : ((i % 5) - 2) * 1.37;
+        ASSERT_TRUE(series.append(t, price));
+        expected_times.push_back(static_cast<double>(t));
+        expected_values.push_back(price);
+    }
+
+    std::vector<double> times;
+    std::vector<double> values;
+    series.decode(times, values);
+    EXPECT_EQ(times, expected_times);
+    EXPECT_EQ(values, expected_values);
+    EXPECT_LT(series.bytes(), expected_values.size() * 2 * sizeof(double) / 2);
+    EXPECT_FALSE(series.append(t - 1, price));
+}
+
+// Test range queries only return points inside the range
+TEST(CompressedSeriesTest, RangeQueries) {
+    CompressedSeries series(16);
+    for(int i = 0; i < 100; i++) {
+        series.append(i * 10, static_cast<double>(i));
+    }
+
+    std::vector<double> times;
+    std::vector<double> values;
+    series.decode_range(205, 400, times, values);
+    ASSERT_EQ(values.size(), 20);
+    EXPECT_EQ(values.front(), 21.0);
+    EXPECT_EQ(values.back(), 40.0);
+
+    auto range = series.min_max(155, 905);
+    ASSERT_TRUE(range.has_value());
+    EXPECT_EQ(range->first, 16.0);
+    EXPECT_EQ(range->second, 90.0);
+    EXPECT_FALSE(series.min_max(2000, 3000).has_value());
+}
+
+
+// Test the frame arena formats without heap allocations and truncates when full
+TEST(FrameArenaTest, FormatsWithoutAllocating) {
+    FrameArena arena(32);
+    std::uint64_t before = heap_allocation_count();
+    const char* a = arena.format("Refresh: {:.0f}s", 42.0);
+    const char* b = arena.format("{} ({:.2f})", "BTC", 1.5);
+    EXPECT_EQ(heap_allocation_count(), before);
+
+    EXPECT_STREQ(a, "Refresh: 42s");
+    EXPECT_STREQ(b, "BTC (1.50)");
+
+    const char* truncated = arena.format("{}", "this string does not fit");
+    EXPECT_LT(std::strlen(truncated), 8);
+    EXPECT_STREQ(arena.format("x"), "");
+
+    arena.reset();
+    EXPECT_STREQ(arena.format("{}", 7), "7");
+}
+
+
+// Test multi-currency parsing keeps every numeric quote
+TEST(MarketClientTest, ParsesMultiCurrencyQuotes) {
+    std::string test_json = R"({"bitcoin": {"usd": 50000.0, "eur": 46000.0, "btc": 1.0}, "ethereum": {"usd": 2500.0, "eur": 2300.0}})";
+    auto quotes = MarketClient::parse_multi_quote(test_json);
+    ASSERT_EQ(quotes.size(), 2);
+    EXPECT_EQ(quotes["bitcoin"]["eur"], 46000.0);
+    EXPECT_EQ(quotes["ethereum"].size(), 2);
+    EXPECT_TRUE(MarketClient::parse_multi_quote("{ broken").empty());
+}
+
+// Test cross rates derived from one batched response
+TEST(FxMatrixTest, DerivesCrossRates) {
+    std::map<std::string, std::map<std::string, double>> quotes = {
+        {"bitcoin", {{"usd", 50000.0}, {"eur", 46000.0}, {"btc", 1.0}}},
+        {"ethereum", {{"usd", 2500.0}, {"eur", 2300.0}, {"btc", 0.05}}},
+    };
+    FxMatrix fx = FxMatrix::from_quotes(quotes);
+
+    EXPECT_EQ(fx.base(), "usd");
+    EXPECT_EQ(fx.currencies().size(), 3);
+    EXPECT_DOUBLE_EQ(fx.rate("usd", "eur"), 0.92);
+    EXPECT_DOUBLE_EQ(fx.rate("eur", "usd"), 1.0 / 0.92);
+    EXPECT_DOUBLE_EQ(fx.convert(2500.0, "usd", "btc"), 0.05);
+    EXPECT_DOUBLE_EQ(fx.rate("eur", "btc") * fx.rate("btc", "eur"), 1.0);
+    EXPECT_EQ(fx.rate("usd", "ils"), 0.0);
+}
+
+
+// Test level alerts fire only for thresholds actually crossed
+TEST(AlertEngineTest, FiresCrossedLevelsOnly) {
+    AlertEngine engine;
+    engine.add_rule({0, "bitcoin", AlertKind::PriceAbove, 100.0});
+    engine.add_rule({0, "bitcoin", AlertKind::PriceAbove, 110.0});
+    engine.add_rule({0, "bitcoin", AlertKind::PriceAbove, 200.0});
+    std::uint64_t below = engine.add_rule({0, "bitcoin", AlertKind::PriceBelow, 90.0});
+
+    engine.on_price("bitcoin", 95.0, 0.0); // No level is past yet, so the first tick only sets the baseline.
+    EXPECT_TRUE(engine.drain_fired().empty());
+
+    engine.on_price("bitcoin", 115.0, 60.0);
+    EXPECT_EQ(engine.drain_fired().size(), 2);
+
+    engine.on_price("bitcoin", 85.0, 120.0);
+    auto fired = engine.drain_fired();
+    ASSERT_EQ(fired.size(), 1);
+    EXPECT_EQ(fired[0].rule_id, below);
+
+    EXPECT_TRUE(engine.remove_rule(below));
+    engine.on_price("bitcoin", 95.0, 180.0);
+    engine.on_price("bitcoin", 85.0, 240.0);
+    EXPECT_TRUE(engine.drain_fired().empty());
+    EXPECT_EQ(engine.rule_count(), 3);
+}
+
+// Test level rules added when the price is already past them fire once, then only on crossings
+TEST(AlertEngineTest, FiresLevelsAlreadyPassed) {
+    AlertEngine engine;
+    engine.add_rule({0, "bitcoin", AlertKind::PriceAbove, 100.0});
+    engine.on_price("bitcoin", 120.0, 0.0); // No price was known when the rule was added.
+    EXPECT_EQ(engine.drain_fired().size(), 1);
+
+    std::uint64_t below = engine.add_rule({0, "bitcoin", AlertKind::PriceBelow, 130.0});
+    engine.add_rule({0, "bitcoin", AlertKind::PriceBelow, 110.0});
+    auto fired = engine.drain_fired();
+    ASSERT_EQ(fired.size(), 1);
+    EXPECT_EQ(fired[0].rule_id, below);
+    EXPECT_EQ(fired[0].price, 120.0);
+
+    engine.on_price("bitcoin", 125.0, 60.0);
+    EXPECT_TRUE(engine.drain_fired().empty());
+}
+
+// Test rules loaded from disk do not re-alert on launch, only on the next crossing
+TEST(AlertEngineTest, RestoredLevelsWaitForACrossing) {
+    AlertEngine engine;
+    std::uint64_t above = engine.add_rule({0, "bitcoin", AlertKind::PriceAbove, 50000.0}, true);
+    engine.on_price("bitcoin", 60000.0, 0.0);
+    EXPECT_TRUE(engine.drain_fired().empty());
+
+    engine.on_price("bitcoin", 45000.0, 60.0);
+    engine.on_price("bitcoin", 55000.0, 120.0);
+    auto fired = engine.drain_fired();
+    ASSERT_EQ(fired.size(), 1);
+    EXPECT_EQ(fired[0].rule_id, above);
+}
+
+// Test percent-move and SMA crossover rules
+TEST(AlertEngineTest, PercentMoveAndCrossover) {
+    AlertEngine engine;
+    AlertRule move{0, "ethereum", AlertKind::PercentMove, 5.0, 600};
+    engine.add_rule(move);
+    AlertRule cross{0, "ethereum", AlertKind::SmaCrossUp, 0.0, 0, 2, 4};
+    engine.add_rule(cross);
+
+    for(int i = 0; i < 5; i++) {
+        engine.on_price("ethereum", 100.0, i * 60.0);
+    }
+    EXPECT_TRUE(engine.drain_fired().empty());
+
+    engine.on_price("ethereum", 106.0, 300.0);
+    EXPECT_EQ(engine.drain_fired().size(), 2); // 6% move and the short SMA jumps above the long one.
+
+    engine.on_price("ethereum", 107.0, 360.0);
+    EXPECT_TRUE(engine.drain_fired().empty()); // Still above threshold; edge-triggered.
+
+    // Rules sharing periods are evaluated together, and a rule added later starts from the kept samples.
+    AlertRule down{0, "ethereum", AlertKind::SmaCrossDown, 0.0, 0, 2, 4};
+    std::uint64_t down_id = engine.add_rule(down);
+    engine.on_price("ethereum", 90.0, 420.0);
+    engine.on_price("ethereum", 90.0, 480.0);
+    auto fired = engine.drain_fired();
+    ASSERT_EQ(fired.size(), 1);
+    EXPECT_EQ(fired[0].rule_id, down_id);
+}
+
+
+// Test correlation signs and VaR on a tiny two-asset portfolio
+TEST(AnalysisTest, RiskOfTwoAssets) {
+    std::vector<double> a = {0.01, -0.02, 0.03, -0.01, 0.02, -0.03};
+    std::vector<double> b;
+    for(double r : a) b.push_back(-r);
+
+    RiskReport report = calculate_risk({a, a}, {1.0, 1.0});
+    ASSERT_EQ(report.assets, 2);
+    EXPECT_NEAR(report.correlation[1], 1.0, 1e-12);
+    EXPECT_NEAR(report.portfolio_volatility, report.volatility[0], 1e-12);
+    EXPECT_NEAR(report.var_historical, 0.03, 1e-12);
+    EXPECT_GT(report.var_parametric, 0.0);
+
+    RiskReport hedged = calculate_risk({a, b}, {1.0, 1.0});
+    EXPECT_NEAR(hedged.correlation[1], -1.0, 1e-12);
+    EXPECT_NEAR(hedged.portfolio_volatility, 0.0, 1e-12);
+
+    EXPECT_EQ(calculate_returns({100.0, 110.0, 99.0}).size(), 2);
+    EXPECT_NEAR(calculate_returns({100.0, 110.0})[0], 0.1, 1e-12);
+}
+
+// Test the blocked, threaded covariance kernel against a direct computation
+TEST(AnalysisTest, BlockedCovarianceMatchesNaive) {
+    const std::size_t assets = 70; // Spans several tiles.
+    const std::size_t samples = 1300; // Spans several time chunks.
+    std::vector<std::vector<double>> returns(assets, std::vector<double>(samples));
+    unsigned seed = 12345;
+    for(auto& series : returns) {
+        for(auto& r : series) {
+            seed = seed * 1103515245 + 12345;
+            r = (static_cast<int>((seed >> 8) % 2001) - 1000) / 100000.0;
+        }
+    }
+
+    RiskReport report = calculate_risk(returns, std::vector<double>(assets, 1.0), 0.95, 4);
+    for(std::size_t i = 0; i < assets; i += 13) {
+        for(std::size_t j = 0; j < assets; j += 7) {
+            double mi = std::accumulate(returns[i].begin(), returns[i].end(), 0.0) / samples;
+            double mj = std::accumulate(returns[j].begin(), returns[j].end(), 0.0) / samples;
+            double cov = 0.0;
+            for(std::size_t t = 0; t < samples; t++) cov += (returns[i][t] - mi) * (returns[j][t] - mj);
+            EXPECT_NEAR(report.covariance[i * assets + j], cov / (samples - 1), 1e-12);
+        }
+    }
+}
+
+
+// Test the fused overlays match the standalone SMA and a reference EMA
+TEST(AnalysisTest, FusedIndicatorsMatchStandalone) {
+    std::vector<double> prices;
+    for(int i = 0; i < 60; i++) prices.push_back(100.0 + (i % 9) * 1.5 - (i % 4));
+
+    FusedIndicators<SmaKernel<20>, EmaKernel<10>> fused;
+    fused.evaluate(prices);
+
+    auto expected = calculate_sma(prices, 20);
+    for(std::size_t i = 19; i < prices.size(); i++) {
+        EXPECT_NEAR(fused.get<0>()[i], expected[i], 1e-9);
+    }
+    EXPECT_TRUE(std::isnan(fused.get<0>()[18]));
+
+    // The EMA is seeded with the SMA of its first full window.
+    double ema = std::accumulate(prices.begin(), prices.begin() + 10, 0.0) / 10.0;
+    EXPECT_TRUE(std::isnan(fused.get<1>()[8]));
+    EXPECT_NEAR(fused.get<1>()[9], ema, 1e-9);
+    for(std::size_t i = 10; i < prices.size(); i++) {
+        ema += 2.0 / 11.0 * (prices[i] - ema);
+        EXPECT_NEAR(fused.get<1>()[i], ema, 1e-9);
+    }
+}
+
+// Test markets parsing tolerates nulls and keeps the sparkline
+TEST(MarketClientTest, ParsesMarketsWithSparklines) {
+    std::string test_json = R"([
+        {"id": "bitcoin", "current_price": 50000.0, "price_change_percentage_24h": -1.5, "sparkline_in_7d": {"price": [1.0, 2.0, 3.0]}},
+        {"id": "newcoin", "current_price": null, "price_change_percentage_24h": null}
+    ])";
+    auto markets = MarketClient::parse_markets(test_json);
+    ASSERT_EQ(markets.size(), 2);
+    EXPECT_EQ(markets[0].id, "bitcoin");
+    EXPECT_EQ(markets[0].change_24h, -1.5);
+    EXPECT_EQ(markets[0].sparkline.size(), 3);
+    EXPECT_EQ(markets[1].current_price, 0.0);
+    EXPECT_TRUE(markets[1].sparkline.empty());
+    EXPECT_TRUE(MarketClient::parse_markets("{ broken").empty());
+}
+
+// Test LTTB keeps the endpoints and the extremes of a series
+TEST(AnalysisTest, LttbKeepsShape) {
+    std::vector<double> values(168, 10.0);
+    values[40] = 25.0;
+    values[120] = 1.0;
+
+    std::vector<double> out;
+    downsample_lttb(values.data(), values.size(), 24, out);
+    ASSERT_EQ(out.size(), 24);
+    EXPECT_EQ(out.front(), values.front());
+    EXPECT_EQ(out.back(), values.back());
+    EXPECT_EQ(*std::max_element(out.begin(), out.end()), 25.0);
+    EXPECT_EQ(*std::min_element(out.begin(), out.end()), 1.0);
+
+    downsample_lttb(values.data(), 10, 24, out);
+    EXPECT_EQ(out.size(), 10);
+}
+
+// Test the async logger writes every line from several threads and rotates its file
+TEST(LoggerTest, WritesFromManyThreadsAndRotates) {
+    auto path = (std::filesystem::temp_directory_path() / "tracker_test.log").string();
+    for(auto const& file : {path, path + ".1", path + ".2", path + ".3"}) std::filesystem::remove(file);
+
+    {
+        Logger logger(256);
+        logger.log(LogLevel::Debug, "filtered {}", 1);
+        logger.start({path, 4096, 3, false});
+
+        std::vector<std::thread> threads;
+        for(int t = 0; t < 4; t++) {
+            threads.emplace_back([&logger, t]() {
+                for(int i = 0; i < 50; i++) {
+                    logger.log(LogLevel::Info, "thread {} line {}", t, i);
+                    if(i % 8 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            });
+        }
+        for(auto& thread : threads) thread.join();
+        logger.flush();
+        logger.stop();
+
+        // About 9 KB of lines rotate twice at 4 KB, and three files hold all of them.
+        EXPECT_TRUE(std::filesystem::exists(path + ".2"));
+        EXPECT_FALSE(std::filesystem::exists(path + ".3"));
+
+        // Oldest file first: every line is intact and each thread's lines come out in order.
+        std::vector<int> last_line(4, -1);
+        int lines = 0;
+        for(auto const& file : {path + ".2", path + ".1", path}) {
+            std::ifstream in(file);
+            std::string line;
+            while(std::getline(in, line)) {
+                int t = -1;
+                int i = -1;
+                auto body = line.find("INFO  thread ");
+                ASSERT_NE(body, std::string::npos) << line;
+                ASSERT_EQ(std::sscanf(line.c_str() + body, "INFO  thread %d line %d", &t, &i), 2) << line;
+                ASSERT_TRUE(t >= 0 && t < 4) << line;
+                EXPECT_EQ(i, last_line[t] + 1) << line;
+                last_line[t] = i;
+                ++lines;
+            }
+        }
+        EXPECT_EQ(logger.dropped(), 0);
+        EXPECT_EQ(lines, 200);
+        EXPECT_EQ(last_line, std::vector<int>(4, 49));
+    }
+    for(auto const& file : {path, path + ".1", path + ".2", path + ".3"}) std::filesystem::remove(file);
+}
+
+// Test a full ring drops new lines instead of blocking
+TEST(LoggerTest, DropsWhenFull) {
+    Logger logger(4);
+    for(int i = 0; i < 10; i++) {
+        logger.log(LogLevel::Error, "line {}", i);
+    }
+    EXPECT_EQ(logger.dropped(), 6);
+}
+
+// Test history points keep their timestamps in seconds
+TEST(MarketClientTest, ParsesHistoryPoints) {
+    std::vector<double> times;
+    std::vector<double> prices;
+    MarketClient::parse_history_points(R"({"prices": [[1700000000000, 10.0], [1700000300000, 11.0]]})", times, prices);
+    ASSERT_EQ(times.size(), 2);
+    EXPECT_EQ(times[1], 1700000300.0);
+    EXPECT_EQ(prices[1], 11.0);
+
+    // Null entries drop their row instead of leaking NaN into the series.
+    MarketClient::parse_history_points(R"({"prices": [[1700000000000, null], [null, 12.0], [1700000600000, 13.0]]})", times, prices);
+    ASSERT_EQ(times.size(), 1);
+    EXPECT_EQ(times[0], 1700000600.0);
+    EXPECT_EQ(prices[0], 13.0);
+
+    MarketClient::parse_history_points("{ broken", times, prices);
+    EXPECT_TRUE(times.empty());
+    EXPECT_TRUE(prices.empty());
+
+    EXPECT_EQ(MarketClient::parse_history(R"({"prices": [[1700000000000, 10.0], [1700000300000, 11.0]]})"), (std::vector<double>{10.0, 11.0}));
+}
+
+// Test extending fused overlays after a trim-and-append matches a full evaluation
+TEST(AnalysisTest, FusedIndicatorsExtendIncrementally) {
+    std::vector<double> prices(288);
+    for(std::size_t i = 0; i < prices.size(); i++) prices[i] = 100.0 + std::sin(i * 0.1) * 5.0;
+
+    FusedIndicators<SmaKernel<7>, EmaKernel<25>> incremental;
+    incremental.evaluate(prices);
+
+    // Drop the 3 oldest points and append 3 new ones, as a delta refresh does.
+    std::vector<double> next(prices.begin() + 3, prices.end());
+    for(int i = 0; i < 3; i++) next.push_back(90.0 + i);
+    incremental.extend(next, 3);
+
+    FusedIndicators<SmaKernel<7>, EmaKernel<25>> full;
+    full.evaluate(prices);
+    ASSERT_EQ(incremental.get<0>().size(), next.size());
+    for(std::size_t i = next.size() - 10; i < next.size(); i++) {
+        double expected = 0.0;
+        for(std::size_t j = i - 6; j <= i; j++) expected += next[j];
+        EXPECT_NEAR(incremental.get<0>()[i], expected / 7, 1e-9);
+    }
+    // The kept points keep the values computed over the untrimmed series.
+    EXPECT_EQ(incremental.get<1>()[30], full.get<1>()[33]);
+
+    // A series that does not continue the last one is simply recomputed.
+    incremental.extend(std::vector<double>(5, 1.0), 400);
+    EXPECT_EQ(incremental.get<0>().size(), 5);
+}
+
+// Test lot matching under each cost method
+TEST(LedgerTest, MatchesLotsPerMethod) {
+    Ledger ledger(CostMethod::Fifo);
+    ASSERT_TRUE(ledger.append({"bitcoin", TradeSide::Buy, 1.0, 100.0, 0.0, 10.0}));
+    ASSERT_TRUE(ledger.append({"bitcoin", TradeSide::Buy, 1.0, 200.0, 0.0, 20.0}));
+    ASSERT_TRUE(ledger.append({"bitcoin", TradeSide::Sell, 1.0, 300.0, 5.0, 30.0}));
+
+    PositionState fifo = ledger.position("bitcoin");
+    EXPECT_DOUBLE_EQ(fifo.amount, 1.0);
+    EXPECT_DOUBLE_EQ(fifo.cost_basis, 200.0);
+    EXPECT_DOUBLE_EQ(fifo.realized_pnl, 195.0);
+    EXPECT_DOUBLE_EQ(fifo.fees, 5.0);
+
+    ledger.set_method(CostMethod::Lifo);
+    EXPECT_DOUBLE_EQ(ledger.position("bitcoin").cost_basis, 100.0);
+    EXPECT_DOUBLE_EQ(ledger.position("bitcoin").realized_pnl, 95.0);
+
+    ledger.set_method(CostMethod::Average);
+    EXPECT_DOUBLE_EQ(ledger.position("bitcoin").cost_basis, 150.0);
+    EXPECT_DOUBLE_EQ(ledger.position("bitcoin").realized_pnl, 145.0);
+    EXPECT_DOUBLE_EQ(ledger.position("bitcoin").unrealized_pnl(170.0), 20.0);
+}
+
+// Test point-in-time queries and rejected trades
+TEST(LedgerTest, PointInTimeAndValidation) {
+    Ledger ledger;
+    for(int i = 0; i < 1000; i++) {
+        ASSERT_TRUE(ledger.append({"ethereum", TradeSide::Buy, 1.0, 10.0 + i, 0.0, static_cast<double>(i)}));
+    }
+    EXPECT_TRUE(ledger.append({"ethereum", TradeSide::TransferOut, 500.0, 0.0, 1.0, 1000.0}));
+
+    EXPECT_EQ(ledger.position("ethereum", -1.0).trades, 0);
+    PositionState mid = ledger.position("ethereum", 99.5);
+    EXPECT_EQ(mid.trades, 100);
+    EXPECT_DOUBLE_EQ(mid.amount, 100.0);
+    EXPECT_DOUBLE_EQ(mid.cost_basis, 100 * 10.0 + 99 * 100 / 2.0);
+
+    PositionState last = ledger.position("ethereum");
+    EXPECT_DOUBLE_EQ(last.amount, 500.0);
+    EXPECT_DOUBLE_EQ(last.realized_pnl, -1.0); // Transfers only realize their fee.
+
+    EXPECT_FALSE(ledger.append({"ethereum", TradeSide::Buy, 1.0, 10.0, 0.0, 5.0}));     // Out of order.
+    EXPECT_FALSE(ledger.append({"ethereum", TradeSide::Sell, 501.0, 10.0, 0.0, 2000.0})); // More than held.
+    EXPECT_FALSE(ledger.append({"solana", TradeSide::Sell, 1.0, 10.0, 0.0, 0.0}));
+    EXPECT_EQ(ledger.columns("solana"), nullptr);
+    EXPECT_EQ(ledger.size(), 1001);
+
+    EXPECT_TRUE(ledger.append({"ethereum", TradeSide::Sell, 500.0, 10.0, 0.0, 2000.0}));
+    EXPECT_EQ(ledger.position("ethereum").amount, 0.0);
+    EXPECT_EQ(ledger.position("ethereum").cost_basis, 0.0);
+
+    EXPECT_TRUE(ledger.append({"solana", TradeSide::Buy, 2.0, 100.0, 0.0, 0.0}));
+    EXPECT_EQ(ledger.erase("ethereum"), 1002);
+    EXPECT_EQ(ledger.erase("ethereum"), 0);
+    EXPECT_EQ(ledger.columns("ethereum"), nullptr);
+    EXPECT_EQ(ledger.size(), 1);
+    EXPECT_EQ(ledger.coins(), std::vector<std::string>{"solana"});
+}
+
+// Test a slow provider is hedged to the next one and the first good answer wins
+TEST(HedgedPriceSourceTest, HedgesSlowProvider) {
+    std::map<std::string, std::map<std::string, double>> quotes{{"bitcoin", {{"usd", 50000.0}, {"eur", 46000.0}}}};
+    auto slow = std::make_shared<StaticPriceProvider>("slow", quotes);
+    auto fast = std::make_shared<StaticPriceProvider>("fast", quotes);
+    slow->set_delay(std::chrono::milliseconds(500));
+
+    HedgingOptions options;
+    options.default_hedge_delay = std::chrono::milliseconds(50);
+    options.timeout = std::chrono::milliseconds(2000);
+    HedgedPriceSource source({slow, fast}, options);
+
+    PriceBatch batch = source.fetch_prices({"bitcoin"}, {"eur"});
+    EXPECT_EQ(batch.prices["bitcoin"], 50000.0);
+    EXPECT_NEAR(batch.fx.rate("usd", "eur"), 0.92, 1e-9);
+
+    // The hedged request answered first; the slow one is still running and counts no win.
+    auto health = source.health();
+    ASSERT_EQ(health.size(), 2);
+    EXPECT_EQ(health[1].wins, 1);
+    EXPECT_EQ(health[0].wins, 0);
+}
+
+// Test the losing attempt is stopped instead of running to the end of its delay
+TEST(HedgedPriceSourceTest, StopsLosingAttempts) {
+    std::map<std::string, std::map<std::string, double>> quotes{{"bitcoin", {{"usd", 50000.0}}}};
+    auto hung = std::make_shared<StaticPriceProvider>("hung", quotes);
+    auto fast = std::make_shared<StaticPriceProvider>("fast", quotes);
+    hung->set_delay(std::chrono::minutes(10));
+
+    HedgingOptions options;
+    options.default_hedge_delay = std::chrono::milliseconds(50);
+    options.timeout = std::chrono::milliseconds(5000);
+    HedgedPriceSource source({hung, fast}, options);
+    EXPECT_FALSE(source.fetch_prices({"bitcoin"}, {}).prices.empty());
+
+    // The stopped attempt reports its run time, well before its ten-minute delay is up.
+    for(int i = 0; i < 500 && source.health()[0].requests == 0; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    auto health = source.health();
+    EXPECT_EQ(health[0].requests, 1);
+    EXPECT_EQ(health[0].wins, 0);
+    EXPECT_GT(health[0].p95_ms, 0.0);
+    EXPECT_EQ(health[0].success_rate, 1.0);
+}
+
+// Test a failing provider falls over immediately and loses its place in the order
+TEST(HedgedPriceSourceTest, FailsOverAndTracksHealth) {
+    std::map<std::string, std::map<std::string, double>> quotes{{"bitcoin", {{"usd", 50000.0}}}};
+    auto broken = std::make_shared<StaticPriceProvider>("broken", quotes);
+    auto backup = std::make_shared<StaticPriceProvider>("backup", quotes);
+    broken->set_failing(true);
+
+    // The hedge delay never passes before the timeout, so only the failure can bring in the backup.
+    HedgingOptions options;
+    options.default_hedge_delay = std::chrono::milliseconds(2000);
+    options.timeout = std::chrono::milliseconds(2000);
+    HedgedPriceSource source({broken, backup}, options);
+
+    EXPECT_FALSE(source.fetch_prices({"bitcoin"}, {}).prices.empty());
+
+    auto health = source.health();
+    EXPECT_EQ(health[1].wins, 1);
+    EXPECT_LT(health[0].success_rate, 1.0);
+    EXPECT_GT(health[1].score, health[0].score);
+
+    // Once every provider fails, the result is empty rather than stale.
+    backup->set_failing(true);
+    EXPECT_TRUE(source.fetch_prices({"bitcoin"}, {}).prices.empty());
+}
+
+// Test rows are extracted identically however the document is split into chunks
+TEST(NumericRowStreamTest, ParsesAcrossChunkBoundaries) {
+    std::string body = R"({"market_caps": [[1, 2]], "prices": [[1700000000000, 42.5], [1700000300000, null], [1700000600000, -1.25e3]], "total_volumes": [[3, 4]]})";
+
+    for(std::size_t chunk : {std::size_t{1}, std::size_t{7}, body.size()}) {
+        std::vector<std::vector<double>> rows;
+        NumericRowStream stream("prices", [&](std::span<const double> row) { rows.emplace_back(row.begin(), row.end()); });
+        for(std::size_t i = 0; i < body.size(); i += chunk) {
+            ASSERT_TRUE(stream.feed(std::string_view(body).substr(i, chunk)));
+        }
+        EXPECT_TRUE(stream.complete());
+        ASSERT_EQ(rows.size(), 3);
+        EXPECT_EQ(rows[0][1], 42.5);
+        EXPECT_TRUE(std::isnan(rows[1][1]));
+        EXPECT_EQ(rows[2][1], -1250.0);
+    }
+}
+
+// Test root-array documents, missing keys and malformed input
+TEST(NumericRowStreamTest, RootArraysAndErrors) {
+    CoinData data;
+    MarketClient::parse_ohlc(R"([[1700000000000, 1, 3, 0.5, 2], [1700001800000, 2, 4, 1, 3]])", data);
+    ASSERT_EQ(data.close.size(), 2);
+    EXPECT_EQ(data.time[1], 1700001800.0);
+    EXPECT_EQ(data.high[0], 3.0);
+
+    MarketClient::parse_ohlc("[[1, 2, 3, 4, 5], oops", data);
+    EXPECT_TRUE(data.time.empty());
+
+    NumericRowStream missing("prices", nullptr);
+    EXPECT_TRUE(missing.feed(R"({"status": {"error_code": 429, "error_message": "[[rate]] limited"}})"));
+    EXPECT_FALSE(missing.complete());
+    EXPECT_FALSE(NumericRowStream("", nullptr).feed("<html>"));
+}
+
+// Test busy coins are polled more often than quiet ones while the request budget holds
+TEST(RefreshSchedulerTest, FavoursVolatileHeldCoinsWithinBudget) {
+    RefreshScheduler scheduler;
+    for(auto const* id : {"bitcoin", "dogecoin", "tether"}) {
+        scheduler.track(id, 0.0);
+    }
+    scheduler.set_volatility("dogecoin", 0.04);
+    scheduler.set_volatility("bitcoin", 0.01);
+    scheduler.set_volatility("tether", 0.0001);
+    scheduler.set_weight("dogecoin", 0.8);
+    scheduler.set_weight("bitcoin", 0.2);
+    scheduler.set_visible("dogecoin", true);
+
+    EXPECT_LT(scheduler.interval("dogecoin"), scheduler.interval("bitcoin"));
+    EXPECT_LT(scheduler.interval("bitcoin"), scheduler.interval("tether"));
+    EXPECT_EQ(scheduler.interval("dogecoin"), 15.0);
+    EXPECT_EQ(scheduler.interval("tether"), 480.0);
+
+    std::map<std::string, int> refreshes;
+    int requests = 0;
+    for(double t = 0.0; t < 3600.0; t += 1.0) {
+        auto due = scheduler.take_due(t);
+        if(due.empty()) continue;
+        ++requests;
+        for(auto const& id : due) refreshes[id]++;
+    }
+    EXPECT_LE(requests, 3 + 2 * 60);
+    EXPECT_GT(refreshes["dogecoin"], 3 * refreshes["bitcoin"]);
+    EXPECT_GT(refreshes["bitcoin"], refreshes["tether"]);
+    EXPECT_GE(refreshes["tether"], 7);
+
+    // A batch with the on-screen coin leaves a request for its chart, and the next one waits for both.
+    RefreshOptions options;
+    options.requests_per_minute = 1.0;
+    RefreshScheduler shown(options);
+    shown.track("dogecoin", 0.0);
+    shown.set_visible("dogecoin", true);
+    ASSERT_FALSE(shown.take_due(0.0).empty());
+    EXPECT_TRUE(shown.try_spend(0.0, 1.0));
+    EXPECT_TRUE(shown.try_spend(0.0, 1.0));
+    EXPECT_EQ(shown.next_due(0.0), 120.0);
+    EXPECT_TRUE(shown.take_due(90.0).empty());
+    EXPECT_FALSE(shown.take_due(120.0).empty());
+}
+
+// Test coalescing, manual refreshes and untracking
+TEST(RefreshSchedulerTest, CoalescesAndChargesManualRefreshes) {
+    RefreshOptions options;
+    options.requests_per_minute = 6.0;
+    options.burst = 3.0;
+    RefreshScheduler scheduler(options);
+    scheduler.track("bitcoin", 0.0);
+    scheduler.track("ethereum", 0.0);
+    ASSERT_EQ(scheduler.interval("bitcoin"), 120.0); // Not held, so twice the base interval.
+
+    auto first = scheduler.take_due(0.0);
+    EXPECT_EQ(first, (std::vector<std::string>{"bitcoin", "ethereum"}));
+    EXPECT_TRUE(scheduler.take_due(1.0).empty());
+    EXPECT_EQ(scheduler.next_due(1.0), 120.0);
+
+    // Ethereum was refreshed by hand later, but is past half its interval when bitcoin falls due.
+    scheduler.mark_refreshed({"ethereum"}, 50.0, 1.0);
+    EXPECT_EQ(scheduler.take_due(120.0).size(), 2);
+
+    // A manual refresh close to that leaves bitcoin to go alone.
+    scheduler.mark_refreshed({"ethereum"}, 200.0, 1.0);
+    EXPECT_EQ(scheduler.take_due(240.0), (std::vector<std::string>{"bitcoin"}));
+
+    // Spending into debt postpones the schedule until the budget recovers.
+    scheduler.mark_refreshed({}, 300.0, 10.0);
+    EXPECT_EQ(scheduler.next_due(300.0), 340.0);
+    EXPECT_TRUE(scheduler.take_due(330.0).empty());
+    EXPECT_FALSE(scheduler.try_spend(330.0, 1.0));
+    EXPECT_EQ(scheduler.take_due(340.0).size(), 2);
+
+    scheduler.untrack("bitcoin");
+    EXPECT_FALSE(scheduler.tracks("bitcoin"));
+    EXPECT_EQ(scheduler.size(), 1);
+    EXPECT_EQ(scheduler.take_due(460.0), (std::vector<std::string>{"ethereum"}));
+}
+
+// Test volatility is the standard deviation of returns
+TEST(AnalysisTest, VolatilityOfReturns) {
+    std::vector<double> prices = {100.0, 110.0, 99.0, 108.9};
+    auto returns = calculate_returns(prices);
+    double mean = std::accumulate(returns.begin(), returns.end(), 0.0) / returns.size();
+    double sq = 0.0;
+    for(double r : returns) sq += (r - mean) * (r - mean);
+    EXPECT_NEAR(calculate_volatility(prices), std::sqrt(sq / (returns.size() - 1)), 1e-12);
+    EXPECT_EQ(calculate_volatility({100.0, 120.0}), 0.0);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+// Test a reader sees what the writer published, and the segment's ownership rules
+TEST(PriceBoardTest, PublishesToReaders) {
+    std::string name = std::format("/mt_board_test_{}", std::chrono::steady_clock::now().time_since_epoch().count());
+    auto writer = PriceBoardWriter::create(name);
+    ASSERT_NE(writer, nullptr);
+    EXPECT_EQ(PriceBoardWriter::create(name), nullptr); // Only one collector per board.
+
+    auto reader = PriceBoardReader::attach(name);
+    ASSERT_NE(reader, nullptr);
+    EXPECT_FALSE(reader->quote("bitcoin").has_value());
+    EXPECT_EQ(reader->publishes(), 0);
+
+    std::vector<double> times(600);
+    std::vector<double> prices(600);
+    std::iota(times.begin(), times.end(), 0.0);
+    std::iota(prices.begin(), prices.end(), 1000.0);
+    EXPECT_TRUE(writer->publish_price("bitcoin", 65000.0, 100.0));
+    EXPECT_TRUE(writer->publish_history("ethereum", times, prices));
+    EXPECT_FALSE(writer->publish_price(std::string(PRICE_BOARD_ID_LENGTH + 1, 'x'), 1.0, 100.0));
+    writer->publish_fx({{"usd", 1.0}, {"eur", 0.9}, {"toolongcode", 2.0}});
+    writer->publish_valuation({1234.5, 1000.0, 12.0, 100.0});
+    writer->commit(100.0);
+
+    EXPECT_EQ(reader->publishes(), 1);
+    EXPECT_EQ(reader->heartbeat(), 100.0);
+    EXPECT_EQ(reader->coin_count(), 2);
+    auto quote = reader->quote("bitcoin");
+    ASSERT_TRUE(quote.has_value());
+    EXPECT_EQ(quote->price, 65000.0);
+    EXPECT_FALSE(reader->quote("ethereum").has_value()); // History only.
+
+    std::vector<double> read_times, read_prices;
+    ASSERT_TRUE(reader->history("ethereum", read_times, read_prices));
+    ASSERT_EQ(read_times.size(), PRICE_BOARD_HISTORY);
+    EXPECT_EQ(read_times.front(), 600.0 - PRICE_BOARD_HISTORY);
+    EXPECT_EQ(read_prices.back(), 1599.0);
+    EXPECT_FALSE(reader->history("bitcoin", read_times, read_prices));
+
+    EXPECT_EQ(reader->fx_rates(), (std::map<std::string, double>{{"eur", 0.9}, {"usd", 1.0}}));
+    auto valuation = reader->valuation();
+    ASSERT_TRUE(valuation.has_value());
+    EXPECT_EQ(valuation->net_worth, 1234.5);
+
+    writer.reset();
+    EXPECT_EQ(reader->quote("bitcoin")->price, 65000.0); // The existing mapping outlives the writer.
+    EXPECT_EQ(PriceBoardReader::attach(name), nullptr);
+}
+
+// Test a collector restarting after a crash never remaps coins under an attached reader
+TEST(PriceBoardTest, RestartAfterCrashLeavesOldReadersConsistent) {
+    std::string name = std::format("/mt_board_crash_{}", std::chrono::steady_clock::now().time_since_epoch().count());
+
+    // A collector that dies without cleaning up: the segment stays, its lock goes with the process.
+    pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if(child == 0) {
+        auto writer = PriceBoardWriter::create(name);
+        bool ok = writer && writer->publish_price("bitcoin", 65000.0, 100.0) && writer->publish_price("ethereum", 3000.0, 100.0);
+        if(ok) writer->commit(100.0);
+        _exit(ok ? 0 : 1);
+    }
+    int status = 0;
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+    ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    auto old_reader = PriceBoardReader::attach(name);
+    ASSERT_NE(old_reader, nullptr);
+    ASSERT_EQ(old_reader->quote("bitcoin")->price, 65000.0);
+
+    // The restarted collector publishes its coins in the opposite order.
+    auto writer = PriceBoardWriter::create(name);
+    ASSERT_NE(writer, nullptr);
+    writer->publish_price("ethereum", 3100.0, 200.0);
+    writer->publish_price("bitcoin", 66000.0, 200.0);
+    writer->commit(200.0);
+
+    // The old mapping is frozen, never rewritten: still the old prices under the right names.
+    EXPECT_EQ(old_reader->publishes(), 1);
+    EXPECT_EQ(old_reader->heartbeat(), 100.0);
+    EXPECT_EQ(old_reader->quote("bitcoin")->price, 65000.0);
+    EXPECT_EQ(old_reader->quote("ethereum")->price, 3000.0);
+
+    auto new_reader = PriceBoardReader::attach(name);
+    ASSERT_NE(new_reader, nullptr);
+    EXPECT_EQ(new_reader->quote("bitcoin")->price, 66000.0);
+    EXPECT_EQ(new_reader->quote("ethereum")->price, 3100.0);
+}
+
+// Test readers never observe a half-written history while the writer keeps publishing
+TEST(PriceBoardTest, ReadsAreNeverTorn) {
+    std::string name = std::format("/mt_board_torn_{}", std::chrono::steady_clock::now().time_since_epoch().count());
+    auto writer = PriceBoardWriter::create(name);
+    ASSERT_NE(writer, nullptr);
+    auto reader = PriceBoardReader::attach(name);
+    ASSERT_NE(reader, nullptr);
+
+    std::atomic<bool> done{false};
+    std::thread publisher([&] {
+        std::vector<double> values(PRICE_BOARD_HISTORY);
+        for(int round = 1; round <= 2000; round++) {
+            std::fill(values.begin(), values.end(), static_cast<double>(round));
+            writer->publish_history("bitcoin", values, values);
+            writer->commit(round);
+        }
+        done = true;
+    });
+
+    std::vector<double> times, prices;
+    while(!done) {
+        if(!reader->history("bitcoin", times, prices)) continue;
+        ASSERT_TRUE(std::all_of(prices.begin(), prices.end(), [&](double p) { return p == prices.front(); }));
+        ASSERT_EQ(times, prices);
+    }
+    publisher.join();
+    ASSERT_TRUE(reader->history("bitcoin", times, prices));
+    EXPECT_EQ(prices.front(), 2000.0);
+}
+#endif